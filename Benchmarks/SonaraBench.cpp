@@ -0,0 +1,407 @@
+#include <benchmark/benchmark.h>
+#include "../Source/PluginProcessor.h"
+
+// Every DSP benchmark takes {block size, sample rate, channels} and reports
+// "per_sample" (time per sample per channel, printed as e.g. 4.2ns) next to
+// the usual time per block. Inputs come from a fixed seed, so two runs of the
+// same build process identical audio.
+//
+// Compare two builds with Google Benchmark's compare.py:
+//   sonara_bench --benchmark_out=before.json --benchmark_out_format=json
+//   ...
+//   compare.py benchmarks before.json after.json
+
+namespace
+{
+    const std::vector<int64_t> blockSizes { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const std::vector<int64_t> sampleRates { 44100, 48000, 96000, 192000 };
+    const std::vector<int64_t> channelCounts { 1, 2 };
+
+    // A mix of keyword hits, modifiers, removals and prose the mapper ignores
+    const char* const promptCorpus[] =
+    {
+        "make it brighter",
+        "more air",
+        "add some sparkle to the top end",
+        "crisp highs please",
+        "warmer and smoother",
+        "more body, a bit thicker",
+        "add room",
+        "big hall reverb, very spacious",
+        "slight ambience",
+        "remove reverb",
+        "more punch",
+        "tighter, glue the mix",
+        "even dynamics with a little compression",
+        "more low end",
+        "deeper bass with some thump",
+        "cut the mids, less boomy",
+        "bring the vocals forward so they cut through",
+        "dark and muddy",
+        "no bright highs",
+        "super bright and airy with a huge distant hall",
+        "warm, punchy and a little roomy",
+        "reduce bass",
+        "make the kick heavier and the snare snappy",
+        "this sounds fine, just leave it",
+        "Can you make the whole thing sound like it was recorded in a large cathedral with lots of atmosphere?",
+        "less compression, more natural",
+        "detailed and clear with more presence",
+        "mellow, soft and sweet",
+        "take away the echo",
+        "extreme glue on the drum bus"
+    };
+
+    // Settings that keep every stage busy: all four bands boosted or cut,
+    // compressor working, reverb on
+    AudioParameters makeBusyParameters()
+    {
+        AudioParameters params;
+        params.eq.highShelfFreq = 8000.0f;
+        params.eq.highShelfGain = 3.0f;
+        params.eq.midFreq = 2500.0f;
+        params.eq.midGain = -2.0f;
+        params.eq.midQ = 1.5f;
+        params.eq.lowMidFreq = 400.0f;
+        params.eq.lowMidGain = 2.0f;
+        params.eq.lowMidQ = 1.0f;
+        params.eq.lowShelfFreq = 120.0f;
+        params.eq.lowShelfGain = 4.0f;
+
+        params.compressor.threshold = -18.0f;
+        params.compressor.ratio = 4.0f;
+        params.compressor.attack = 5.0f;
+        params.compressor.release = 120.0f;
+        params.compressor.makeupGain = 3.0f;
+        params.compressor.enabled = true;
+
+        params.reverb.roomSize = 0.7f;
+        params.reverb.damping = 0.5f;
+        params.reverb.width = 1.0f;
+        params.reverb.wetLevel = 0.3f;
+        params.reverb.dryLevel = 0.8f;
+        params.reverb.enabled = true;
+        return params;
+    }
+
+    struct BlockConfig
+    {
+        int blockSize;
+        double sampleRate;
+        int numChannels;
+    };
+
+    BlockConfig getBlockConfig(const benchmark::State& state)
+    {
+        return { (int)state.range(0), (double)state.range(1), (int)state.range(2) };
+    }
+
+    juce::dsp::ProcessSpec makeSpec(const BlockConfig& config)
+    {
+        return { config.sampleRate, (juce::uint32)config.blockSize, (juce::uint32)config.numChannels };
+    }
+
+    // 64k samples of gently low-passed noise, about -18 dBFS RMS; each iteration copies
+    // the next block out of it so processors never see the same input twice
+    // in a row but every run sees the same sequence, at either precision
+    template <typename SampleType = float>
+    class NoiseSource
+    {
+    public:
+        explicit NoiseSource(const BlockConfig& config) : source(config.numChannels, 65536), block(config.numChannels, config.blockSize)
+        {
+            juce::Random random(0x50a7a);
+            for (int channel = 0; channel < source.getNumChannels(); ++channel)
+            {
+                auto* data = source.getWritePointer(channel);
+                float smoothed = 0.0f;
+                for (int i = 0; i < source.getNumSamples(); ++i)
+                {
+                    smoothed = 0.7f * smoothed + 0.3f * (random.nextFloat() * 2.0f - 1.0f);
+                    data[i] = (SampleType)(smoothed * 0.5f);
+                }
+            }
+        }
+
+        juce::AudioBuffer<SampleType>& next()
+        {
+            const int blockSize = block.getNumSamples();
+            if (position + blockSize > source.getNumSamples())
+                position = 0;
+
+            for (int channel = 0; channel < block.getNumChannels(); ++channel)
+                block.copyFrom(channel, 0, source, channel, position, blockSize);
+
+            position += blockSize;
+            return block;
+        }
+
+    private:
+        juce::AudioBuffer<SampleType> source;
+        juce::AudioBuffer<SampleType> block;
+        int position = 0;
+    };
+
+    void setSampleCounters(benchmark::State& state, const BlockConfig& config)
+    {
+        const auto samples = (int64_t)state.iterations() * config.blockSize * config.numChannels;
+        state.SetItemsProcessed(samples);
+        state.counters["per_sample"] = benchmark::Counter((double)samples, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    }
+
+    // Runs processBlock on a steady stream of noise. The first second is
+    // processed untimed so ramps, envelopes and the reverb tank have settled.
+    template <typename SampleType = float, typename Processor>
+    void runBlocks(benchmark::State& state, Processor& processor, const BlockConfig& config)
+    {
+        NoiseSource<SampleType> noise(config);
+
+        for (int warmedUp = 0; warmedUp < (int)config.sampleRate; warmedUp += config.blockSize)
+            processor.processBlock(noise.next());
+
+        for (auto _ : state)
+        {
+            auto& block = noise.next();
+            processor.processBlock(block);
+            benchmark::DoNotOptimize(block.getReadPointer(0));
+            benchmark::ClobberMemory();
+        }
+
+        setSampleCounters(state, config);
+    }
+
+    void applyBlockArgs(benchmark::internal::Benchmark* bench)
+    {
+        bench->ArgNames({ "block", "rate", "channels" })->ArgsProduct({ blockSizes, sampleRates, channelCounts });
+    }
+}
+
+static void BM_Equalizer(benchmark::State& state)
+{
+    const auto config = getBlockConfig(state);
+    const auto params = makeBusyParameters();
+
+    Equalizer<float> equalizer;
+    equalizer.prepare(makeSpec(config));
+    equalizer.setBand(0, Equalizer<float>::BandType::lowShelf, params.eq.lowShelfFreq, params.eq.lowShelfGain);
+    equalizer.setBand(1, Equalizer<float>::BandType::peak, params.eq.lowMidFreq, params.eq.lowMidGain, params.eq.lowMidQ);
+    equalizer.setBand(2, Equalizer<float>::BandType::peak, params.eq.midFreq, params.eq.midGain, params.eq.midQ);
+    equalizer.setBand(3, Equalizer<float>::BandType::highShelf, params.eq.highShelfFreq, params.eq.highShelfGain);
+    equalizer.reset();
+
+    runBlocks(state, equalizer, config);
+}
+BENCHMARK(BM_Equalizer)->Apply(applyBlockArgs);
+
+// Every band in use: what a richer prompt costs over the usual four
+static void BM_EqualizerAllBands(benchmark::State& state)
+{
+    const auto config = getBlockConfig(state);
+
+    Equalizer<float> equalizer;
+    equalizer.prepare(makeSpec(config));
+    for (size_t band = 0; band < Equalizer<float>::maxBands; ++band)
+        equalizer.setBand(band, Equalizer<float>::BandType::peak, 100.0f * (float)(band + 1) * (float)(band + 1), band % 2 == 0 ? 2.0f : -2.0f, 1.5f);
+    equalizer.reset();
+
+    runBlocks(state, equalizer, config);
+}
+BENCHMARK(BM_EqualizerAllBands)->Apply(applyBlockArgs);
+
+// Equalizer with a band permanently mid-glide, i.e. the cost of the
+// coefficient ramp path while someone is sweeping a parameter
+static void BM_EqualizerGliding(benchmark::State& state)
+{
+    const auto config = getBlockConfig(state);
+
+    Equalizer<float> equalizer;
+    equalizer.prepare(makeSpec(config));
+    equalizer.reset();
+
+    NoiseSource<> noise(config);
+    float gainDb = 0.0f;
+
+    for (auto _ : state)
+    {
+        gainDb = gainDb > 6.0f ? -6.0f : gainDb + 0.5f;
+        equalizer.setBand(0, Equalizer<float>::BandType::peak, 1000.0f, gainDb, 1.0f);
+
+        auto& block = noise.next();
+        equalizer.processBlock(block);
+        benchmark::DoNotOptimize(block.getReadPointer(0));
+        benchmark::ClobberMemory();
+    }
+
+    setSampleCounters(state, config);
+}
+BENCHMARK(BM_EqualizerGliding)->Apply(applyBlockArgs);
+
+static void BM_Compressor(benchmark::State& state)
+{
+    const auto config = getBlockConfig(state);
+    const auto params = makeBusyParameters();
+
+    Compressor compressor;
+    compressor.prepare(makeSpec(config));
+    compressor.setThreshold(params.compressor.threshold);
+    compressor.setRatio(params.compressor.ratio);
+    compressor.setAttack(params.compressor.attack);
+    compressor.setRelease(params.compressor.release);
+    compressor.setMakeupGain(params.compressor.makeupGain);
+    compressor.setEnabled(params.compressor.enabled);
+    compressor.reset();
+
+    runBlocks(state, compressor, config);
+}
+BENCHMARK(BM_Compressor)->Apply(applyBlockArgs);
+
+static void BM_Reverb(benchmark::State& state)
+{
+    const auto config = getBlockConfig(state);
+    const auto params = makeBusyParameters();
+
+    ReverbProcessor reverb;
+    reverb.prepare(makeSpec(config));
+    reverb.setRoomSize(params.reverb.roomSize);
+    reverb.setDamping(params.reverb.damping);
+    reverb.setWidth(params.reverb.width);
+    reverb.setWetLevel(params.reverb.wetLevel);
+    reverb.setDryLevel(params.reverb.dryLevel);
+    reverb.setEnabled(params.reverb.enabled);
+    reverb.reset();
+
+    runBlocks(state, reverb, config);
+}
+BENCHMARK(BM_Reverb)->Apply(applyBlockArgs);
+
+// The whole plugin as a host would drive it, including the parameter
+// handoff check at the top of every block
+static void BM_PluginProcessBlock(benchmark::State& state)
+{
+    const auto config = getBlockConfig(state);
+
+    SonaraAudioProcessor processor;
+    processor.setPlayConfigDetails(config.numChannels, config.numChannels, config.sampleRate, config.blockSize);
+    processor.prepareToPlay(config.sampleRate, config.blockSize);
+    processor.processTextInput("warm punchy hall reverb with more air");
+
+    NoiseSource<> noise(config);
+    juce::MidiBuffer midi;
+
+    for (int warmedUp = 0; warmedUp < (int)config.sampleRate; warmedUp += config.blockSize)
+        processor.processBlock(noise.next(), midi);
+
+    for (auto _ : state)
+    {
+        auto& block = noise.next();
+        processor.processBlock(block, midi);
+        benchmark::DoNotOptimize(block.getReadPointer(0));
+        benchmark::ClobberMemory();
+    }
+
+    processor.releaseResources();
+    setSampleCounters(state, config);
+}
+BENCHMARK(BM_PluginProcessBlock)->Apply(applyBlockArgs);
+
+// An idle track: the full chain enabled but fed digital silence, measured
+// after the reverb tail has rung out and the chain has gone to sleep
+static void BM_ProcessingChainSilent(benchmark::State& state)
+{
+    const auto config = getBlockConfig(state);
+
+    ProcessingChain<float> chain;
+    chain.prepare(makeSpec(config));
+    chain.setParameters(makeBusyParameters());
+    chain.reset();
+
+    juce::AudioBuffer<float> block(config.numChannels, config.blockSize);
+    block.clear();
+
+    const auto tailSamples = (int)(chain.getTailLengthSeconds() * config.sampleRate) + config.blockSize;
+    for (int warmedUp = 0; warmedUp < tailSamples; warmedUp += config.blockSize)
+        chain.processBlock(block);
+
+    for (auto _ : state)
+    {
+        chain.processBlock(block);
+        benchmark::DoNotOptimize(block.getReadPointer(0));
+        benchmark::ClobberMemory();
+    }
+
+    setSampleCounters(state, config);
+}
+BENCHMARK(BM_ProcessingChainSilent)->Apply(applyBlockArgs);
+
+// The busy chain at either precision, for what a host running the plugin
+// in double pays over float
+template <typename SampleType>
+static void BM_ProcessingChain(benchmark::State& state)
+{
+    const auto config = getBlockConfig(state);
+
+    ProcessingChain<SampleType> chain;
+    chain.prepare(makeSpec(config));
+    chain.setParameters(makeBusyParameters());
+    chain.reset();
+
+    runBlocks<SampleType>(state, chain, config);
+}
+BENCHMARK_TEMPLATE(BM_ProcessingChain, float)->Apply(applyBlockArgs);
+BENCHMARK_TEMPLATE(BM_ProcessingChain, double)->Apply(applyBlockArgs);
+
+// Mapping throughput over the whole corpus; reported as prompts per second
+static void BM_KeywordMapperProcessText(benchmark::State& state)
+{
+    KeywordMapper mapper;
+
+    juce::StringArray prompts;
+    for (auto* prompt : promptCorpus)
+        prompts.add(prompt);
+
+    for (auto _ : state)
+    {
+        for (const auto& prompt : prompts)
+        {
+            auto params = mapper.processText(prompt, 1.0f);
+            benchmark::DoNotOptimize(params);
+        }
+    }
+
+    const auto numPrompts = (int64_t)state.iterations() * prompts.size();
+    state.SetItemsProcessed(numPrompts);
+    state.counters["prompts"] = benchmark::Counter((double)numPrompts, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_KeywordMapperProcessText);
+
+// What an intensity slider tick costs once the prompt has been mapped
+static void BM_KeywordMapperApplyIntensity(benchmark::State& state)
+{
+    KeywordMapper mapper;
+    const auto mapped = mapper.mapText(promptCorpus[0]);
+
+    float intensity = 0.0f;
+    for (auto _ : state)
+    {
+        intensity = intensity >= 2.0f ? 0.0f : intensity + 0.1f;
+        auto params = KeywordMapper::applyIntensity(mapped, intensity);
+        benchmark::DoNotOptimize(params);
+    }
+
+    state.SetItemsProcessed((int64_t)state.iterations());
+}
+BENCHMARK(BM_KeywordMapperApplyIntensity);
+
+int main(int argc, char** argv)
+{
+    // SonaraAudioProcessor and its editor expect JUCE to be initialised
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Everything the processing chain needs to know, as produced by KeywordMapper
+struct AudioParameters {
+    // EQ Parameters
+    struct EQ {
+        float highShelfFreq = 10000.0f;
+        float highShelfGain = 0.0f;
+        
+        // Upper mids: presence and clarity
+        float midFreq = 2000.0f;
+        float midGain = 0.0f;
+        float midQ = 1.0f;
+        
+        // Lower mids: warmth and body, so they don't fight presence for one band
+        float lowMidFreq = 500.0f;
+        float lowMidGain = 0.0f;
+        float lowMidQ = 1.0f;
+        
+        float lowShelfFreq = 100.0f;
+        float lowShelfGain = 0.0f;
+    } eq;
+    
+    // Compressor Parameters
+    struct Compressor {
+        float threshold = 0.0f;
+        float ratio = 1.0f;
+        float attack = 10.0f;
+        float release = 100.0f;
+        float makeupGain = 0.0f;
+        bool enabled = false;
+    } compressor;
+    
+    // Reverb Parameters
+    struct Reverb {
+        float roomSize = 0.0f;
+        float damping = 0.0f;
+        float width = 1.0f;
+        float wetLevel = 0.0f;
+        float dryLevel = 1.0f;
+        bool enabled = false;
+    } reverb;
+    
+    float intensity = 1.0f; // Global intensity multiplier
+};
@@ -0,0 +1,78 @@
+#include "BiquadDesign.h"
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cmath>
+
+namespace {
+    template <typename SampleType>
+    void store(SampleType* dest, double b0, double b1, double b2, double a0, double a1, double a2) {
+        const double a0Inverse = 1.0 / a0;
+        dest[0] = (SampleType)(b0 * a0Inverse);
+        dest[1] = (SampleType)(b1 * a0Inverse);
+        dest[2] = (SampleType)(b2 * a0Inverse);
+        dest[3] = (SampleType)(a1 * a0Inverse);
+        dest[4] = (SampleType)(a2 * a0Inverse);
+    }
+    
+    double angularFrequency(double sampleRate, double frequency) {
+        return juce::MathConstants<double>::twoPi * juce::jmax(frequency, 2.0) / sampleRate;
+    }
+}
+
+namespace BiquadDesign {
+    template <typename SampleType>
+    void makeLowShelf(SampleType* dest, double sampleRate, double frequency, double q, double gainDb) {
+        const double A = std::sqrt(juce::Decibels::decibelsToGain(gainDb));
+        const double omega = angularFrequency(sampleRate, frequency);
+        const double cosOmega = std::cos(omega);
+        const double beta = std::sin(omega) * std::sqrt(A) / q;
+        const double aMinus1TimesCos = (A - 1.0) * cosOmega;
+        
+        store(dest,
+              A * ((A + 1.0) - aMinus1TimesCos + beta),
+              A * 2.0 * ((A - 1.0) - (A + 1.0) * cosOmega),
+              A * ((A + 1.0) - aMinus1TimesCos - beta),
+              (A + 1.0) + aMinus1TimesCos + beta,
+              -2.0 * ((A - 1.0) + (A + 1.0) * cosOmega),
+              (A + 1.0) + aMinus1TimesCos - beta);
+    }
+    
+    template <typename SampleType>
+    void makeHighShelf(SampleType* dest, double sampleRate, double frequency, double q, double gainDb) {
+        const double A = std::sqrt(juce::Decibels::decibelsToGain(gainDb));
+        const double omega = angularFrequency(sampleRate, frequency);
+        const double cosOmega = std::cos(omega);
+        const double beta = std::sin(omega) * std::sqrt(A) / q;
+        const double aMinus1TimesCos = (A - 1.0) * cosOmega;
+        
+        store(dest,
+              A * ((A + 1.0) + aMinus1TimesCos + beta),
+              A * -2.0 * ((A - 1.0) + (A + 1.0) * cosOmega),
+              A * ((A + 1.0) + aMinus1TimesCos - beta),
+              (A + 1.0) - aMinus1TimesCos + beta,
+              2.0 * ((A - 1.0) - (A + 1.0) * cosOmega),
+              (A + 1.0) - aMinus1TimesCos - beta);
+    }
+    
+    template <typename SampleType>
+    void makePeakFilter(SampleType* dest, double sampleRate, double frequency, double q, double gainDb) {
+        const double A = std::sqrt(juce::Decibels::decibelsToGain(gainDb));
+        const double omega = angularFrequency(sampleRate, frequency);
+        const double alpha = std::sin(omega) / (q * 2.0);
+        const double c2 = -2.0 * std::cos(omega);
+        
+        store(dest,
+              1.0 + alpha * A,
+              c2,
+              1.0 - alpha * A,
+              1.0 + alpha / A,
+              c2,
+              1.0 - alpha / A);
+    }
+    
+    template void makeLowShelf<float>(float*, double, double, double, double);
+    template void makeLowShelf<double>(double*, double, double, double, double);
+    template void makeHighShelf<float>(float*, double, double, double, double);
+    template void makeHighShelf<double>(double*, double, double, double, double);
+    template void makePeakFilter<float>(float*, double, double, double, double);
+    template void makePeakFilter<double>(double*, double, double, double, double);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// In-place biquad designers. Each one writes normalised coefficients
+// { b0, b1, b2, a1, a2 } straight into the caller's storage, so computing a
+// new EQ curve never goes near the allocator. Curves match juce::dsp::IIR's
+// makeLowShelf / makeHighShelf / makePeakFilter; the maths runs in double
+// precision to keep low shelves accurate at high sample rates, and is only
+// rounded to float for float filters. Instantiated for float and double.
+namespace BiquadDesign {
+    template <typename SampleType>
+    void makeLowShelf(SampleType* dest, double sampleRate, double frequency, double q, double gainDb);
+    
+    template <typename SampleType>
+    void makeHighShelf(SampleType* dest, double sampleRate, double frequency, double q, double gainDb);
+    
+    template <typename SampleType>
+    void makePeakFilter(SampleType* dest, double sampleRate, double frequency, double q, double gainDb);
+}
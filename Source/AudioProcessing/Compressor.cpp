@@ -1,17 +1,77 @@
 #include "Compressor.h"
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    // 20 * log10(2): converts between decibels and log2 units
+    constexpr float decibelsPerLog2 = 6.0205999f;
+    
+    // Polynomial approximations, accurate to ~0.01 dB over the range a
+    // compressor cares about. Written without branches, divides or library
+    // calls so the loop in computeGain() auto-vectorises.
+    inline float fastLog2(float x) {
+        std::uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        
+        float exponent = (float)((int)((bits >> 23) & 0xff) - 127);
+        bits = (bits & 0x007fffffu) | 0x3f800000u;
+        
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+        m -= 1.0f;
+        
+        return exponent + (0.000203723308f + m * (1.43610242f + m * (-0.66952725f + m * (0.312226147f - 0.0791538344f * m))));
+    }
+    
+    // Only valid for x in [-125, 126]; callers bound their input instead of
+    // clamping here, a clamp at this point stops gcc vectorising
+    inline float fastExp2(float x) {
+        // Adding 2^23 rounds to an integer that lands in the low mantissa bits
+        float biased = x + 127.0f;
+        float rounded = (biased - 0.5f) + 8388608.0f;
+        float fraction = biased - (rounded - 8388608.0f);
+        
+        std::uint32_t bits;
+        std::memcpy(&bits, &rounded, sizeof(bits));
+        bits <<= 23;
+        
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        
+        return scale * (1.0f + fraction * (0.6931472f + fraction * (0.2402265f + fraction * (0.0555041f + fraction * 0.0096181f))));
+    }
+    
+    inline void applyGain(float* samples, const float* gain, int numSamples) {
+        juce::FloatVectorOperations::multiply(samples, gain, numSamples);
+    }
+    
+    inline void applyGain(double* samples, const float* gain, int numSamples) {
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] *= (double)gain[i];
+    }
+}
 
 Compressor::Compressor() {
     reset();
 }
 
-void Compressor::setSampleRate(double sampleRate) {
-    currentSampleRate = sampleRate;
-    envelope = 0.0f;
+void Compressor::prepare(const juce::dsp::ProcessSpec& processSpec) {
+    jassert(processSpec.numChannels <= (juce::uint32)maxChannels);
+    
+    currentSampleRate = processSpec.sampleRate;
+    thresholdLog2.reset(currentSampleRate);
+    makeupLog2.reset(currentSampleRate);
+    slope.reset(currentSampleRate);
+    reset();
 }
 
 void Compressor::reset() {
-    envelope = 0.0f;
+    envelopes.fill(0.0f);
     updateCompressorSettings();
+    
+    thresholdLog2.snapToTarget();
+    makeupLog2.snapToTarget();
+    slope.snapToTarget();
 }
 
 void Compressor::setThreshold(float thresholdDb) {
@@ -36,47 +96,128 @@ void Compressor::setRelease(float releaseMs) {
 
 void Compressor::setMakeupGain(float gainDb) {
     makeupGain = gainDb;
+    updateCompressorSettings();
 }
 
 void Compressor::setEnabled(bool en) {
+    // Coming back from idle: the detectors haven't seen the audio since
+    if (en && !isActive())
+        envelopes.fill(0.0f);
+    
     enabled = en;
+    updateCompressorSettings();
+}
+
+bool Compressor::isActive() const {
+    return enabled || slope.isSmoothing() || makeupLog2.isSmoothing();
+}
+
+void Compressor::skipSilence(juce::int64 numSamples) {
+    // With nothing coming in, each sample only scales an envelope by releaseCoeff
+    const float decay = (float)std::pow((double)releaseCoeff, (double)numSamples);
+    for (auto& envelope : envelopes)
+        envelope *= decay;
+    
+    // Nothing would be heard of ramps still running, so they can finish now
+    thresholdLog2.snapToTarget();
+    makeupLog2.snapToTarget();
+    slope.snapToTarget();
 }
 
-void Compressor::processBlock(juce::AudioBuffer<float>& buffer) {
-    if (!enabled) return;
+void Compressor::setDetectorMode(DetectorMode mode) {
+    if (mode != detectorMode) {
+        detectorMode = mode;
+        
+        // Switching modes changes what each detector slot means
+        envelopes.fill(0.0f);
+    }
+}
+
+template <typename SampleType>
+void Compressor::processBlock(juce::AudioBuffer<SampleType>& buffer) {
+    if (!isActive()) return;
     
-    float thresholdGain = juce::Decibels::decibelsToGain(threshold);
-    float attackCoeff = std::exp(-1.0f / (attack * 0.001f * (float)currentSampleRate));
-    float releaseCoeff = std::exp(-1.0f / (release * 0.001f * (float)currentSampleRate));
-    float makeupGainLinear = juce::Decibels::decibelsToGain(makeupGain);
+    jassert(buffer.getNumChannels() <= maxChannels);
+    const int numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+    auto* const* channels = buffer.getArrayOfWritePointers();
     
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
-        auto* channelData = buffer.getWritePointer(channel);
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-            float input = channelData[sample];
-            float inputLevel = std::abs(input);
-            
-            // Envelope follower with attack/release
-            if (inputLevel > envelope) {
-                envelope = inputLevel + (envelope - inputLevel) * attackCoeff;
-            } else {
-                envelope = inputLevel + (envelope - inputLevel) * releaseCoeff;
-            }
-            
-            // Calculate gain reduction
-            float gainReduction = 1.0f;
-            if (envelope > thresholdGain) {
-                float overThreshold = envelope - thresholdGain;
-                float compressedLevel = thresholdGain + (overThreshold / ratio);
-                gainReduction = compressedLevel / envelope;
-            }
+    for (int start = 0; start < buffer.getNumSamples(); start += chunkSize) {
+        const int numSamples = juce::jmin(chunkSize, buffer.getNumSamples() - start);
+        
+        thresholdLog2.fill(thresholdBuffer.data(), numSamples);
+        makeupLog2.fill(makeupBuffer.data(), numSamples);
+        slope.fill(slopeBuffer.data(), numSamples);
+        
+        if (detectorMode == DetectorMode::linked)
+            processLinked(channels, numChannels, start, numSamples);
+        else
+            processUnlinked(channels, numChannels, start, numSamples);
+    }
+}
+
+template <typename SampleType>
+void Compressor::processLinked(SampleType* const* channels, int numChannels, int start, int numSamples) {
+    float envelope = envelopes[0];
+    auto& envelopeData = envelopeBuffers[0];
+    
+    // Envelope follower with attack/release on the loudest channel
+    for (int i = 0; i < numSamples; ++i) {
+        float inputLevel = 0.0f;
+        for (int channel = 0; channel < numChannels; ++channel)
+            inputLevel = juce::jmax(inputLevel, (float)std::abs(channels[channel][start + i]));
+        
+        float coeff = inputLevel > envelope ? attackCoeff : releaseCoeff;
+        envelope = inputLevel + (envelope - inputLevel) * coeff;
+        envelopeData[(size_t)i] = envelope;
+    }
+    
+    envelopes[0] = envelope;
+    computeGain(envelopeData.data(), gainBuffers[0].data(), numSamples);
+    
+    // Apply the same gain reduction and makeup gain to every channel
+    for (int channel = 0; channel < numChannels; ++channel)
+        applyGain(channels[channel] + start, gainBuffers[0].data(), numSamples);
+}
+
+template <typename SampleType>
+void Compressor::processUnlinked(SampleType* const* channels, int numChannels, int start, int numSamples) {
+    // Envelope followers for all channels advance together, sample by sample
+    for (int i = 0; i < numSamples; ++i) {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float inputLevel = (float)std::abs(channels[channel][start + i]);
+            float& envelope = envelopes[(size_t)channel];
             
-            // Apply gain reduction and makeup gain
-            channelData[sample] = input * gainReduction * makeupGainLinear;
+            float coeff = inputLevel > envelope ? attackCoeff : releaseCoeff;
+            envelope = inputLevel + (envelope - inputLevel) * coeff;
+            envelopeBuffers[(size_t)channel][(size_t)i] = envelope;
         }
     }
+    
+    for (int channel = 0; channel < numChannels; ++channel) {
+        computeGain(envelopeBuffers[(size_t)channel].data(), gainBuffers[(size_t)channel].data(), numSamples);
+        applyGain(channels[channel] + start, gainBuffers[(size_t)channel].data(), numSamples);
+    }
+}
+
+void Compressor::computeGain(const float* envelopeData, float* gainData, int numSamples) const {
+    // Static curve in the log domain: every log2 unit above threshold is
+    // reduced by (1 - 1/ratio), makeup is folded into the same exponent
+    for (int i = 0; i < numSamples; ++i) {
+        float levelLog2 = fastLog2(envelopeData[i] + 1.0e-9f);
+        float overThreshold = juce::jlimit(0.0f, 100.0f, levelLog2 - thresholdBuffer[(size_t)i]);
+        gainData[i] = fastExp2(makeupBuffer[(size_t)i] - overThreshold * slopeBuffer[(size_t)i]);
+    }
 }
 
 void Compressor::updateCompressorSettings() {
-    // Settings are applied in processBlock
+    const double samplesPerMs = currentSampleRate * 0.001;
+    attackCoeff = (float)std::exp(-1.0 / juce::jmax(1.0, attack * samplesPerMs));
+    releaseCoeff = (float)std::exp(-1.0 / juce::jmax(1.0, release * samplesPerMs));
+    
+    thresholdLog2.setTarget(threshold / decibelsPerLog2);
+    makeupLog2.setTarget(enabled ? makeupGain / decibelsPerLog2 : 0.0f);
+    slope.setTarget(enabled && ratio > 0.0f ? 1.0f - 1.0f / ratio : 0.0f);
 }
+
+template void Compressor::processBlock<float>(juce::AudioBuffer<float>&);
+template void Compressor::processBlock<double>(juce::AudioBuffer<double>&);
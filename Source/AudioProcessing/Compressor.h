@@ -2,12 +2,22 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "ParameterSmoothing.h"
+#include <array>
 
 class Compressor {
 public:
+    // Linked: one detector fed by the loudest channel, same gain on every
+    // channel (keeps the stereo image). Unlinked: each channel is compressed
+    // by its own detector.
+    enum class DetectorMode {
+        linked,
+        unlinked
+    };
+    
     Compressor();
     
-    void setSampleRate(double sampleRate);
+    void prepare(const juce::dsp::ProcessSpec& processSpec);
     void reset();
     
     // Compressor Parameters
@@ -17,8 +27,20 @@ public:
     void setRelease(float releaseMs);
     void setMakeupGain(float gainDb);
     void setEnabled(bool enabled);
+    void setDetectorMode(DetectorMode mode);
+    
+    // Runs on float or double buffers; the detector and gain computer work
+    // in float either way, only the gain is applied at the buffer's precision
+    template <typename SampleType>
+    void processBlock(juce::AudioBuffer<SampleType>& buffer);
+    
+    // False once disabled and ramped out; processBlock is then a no-op.
+    // Silence in gives silence out, so there is never a tail to wait for
+    bool isActive() const;
     
-    void processBlock(juce::AudioBuffer<float>& buffer);
+    // Accounts for numSamples of silence that weren't processed: the
+    // detectors release exactly as far as processBlock would have taken them
+    void skipSilence(juce::int64 numSamples);
     
 private:
     float threshold = 0.0f;
@@ -27,10 +49,42 @@ private:
     float release = 100.0f;
     float makeupGain = 0.0f;
     bool enabled = false;
+    DetectorMode detectorMode = DetectorMode::linked;
     
     double currentSampleRate = 44100.0;
-    float envelope = 0.0f;
+    
+    // Cached by updateCompressorSettings() whenever a setter changes a value.
+    // Threshold and makeup are kept in log2 units so the gain computer can
+    // work on fast log2/exp2 approximations directly. The curve parameters
+    // glide to new values; disabling ramps slope and makeup down to unity
+    // gain before processing stops.
+    float attackCoeff = 0.0f;
+    float releaseCoeff = 0.0f;
+    SmoothedParameter thresholdLog2;
+    SmoothedParameter makeupLog2;
+    SmoothedParameter slope;
+    
+    // Samples are processed in fixed-size chunks: a serial envelope pass that
+    // walks all channels sample by sample, followed by a vectorisable gain
+    // computer pass over the whole chunk
+    static constexpr int chunkSize = 64;
+    static constexpr int maxChannels = 8;
+    
+    // Per-channel detector state; linked mode only uses the first slot
+    std::array<float, maxChannels> envelopes {};
+    std::array<std::array<float, chunkSize>, maxChannels> envelopeBuffers {};
+    std::array<std::array<float, chunkSize>, maxChannels> gainBuffers {};
+    std::array<float, chunkSize> thresholdBuffer {};
+    std::array<float, chunkSize> makeupBuffer {};
+    std::array<float, chunkSize> slopeBuffer {};
     
     void updateCompressorSettings();
+    
+    template <typename SampleType>
+    void processLinked(SampleType* const* channels, int numChannels, int start, int numSamples);
+    
+    template <typename SampleType>
+    void processUnlinked(SampleType* const* channels, int numChannels, int start, int numSamples);
+    
+    void computeGain(const float* envelopeData, float* gainData, int numSamples) const;
 };
-
@@ -1,79 +1,228 @@
 #include "Equalizer.h"
+#include "BiquadDesign.h"
 
-Equalizer::Equalizer() {
+template <typename SampleType>
+Equalizer<SampleType>::Equalizer() {
+    bands.fill({ BandType::peak, 1000.0f, 0.0f, 1.0f });
+    
+    for (size_t band = 0; band < maxBands; ++band)
+        updateBand(band);
+    
+    // Usable straight away; the host's prepareToPlay replaces this
+    prepare({ 44100.0, 512, 2 });
+}
+
+template <typename SampleType>
+void Equalizer<SampleType>::prepare(const juce::dsp::ProcessSpec& processSpec) {
+    jassert(processSpec.numChannels <= (juce::uint32)maxChannels);
+    
+    for (auto& ramp : coefficientRamps)
+        ramp.reset(processSpec.sampleRate);
+    
+    sampleRate = processSpec.sampleRate;
+    interleaved.assign(juce::jmax((size_t)1, (size_t)processSpec.maximumBlockSize), Vector::expand(0));
+    
+    // Fresh filter state, so start on the current settings rather than glide
+    isPrepared = true;
+    for (size_t band = 0; band < maxBands; ++band)
+        updateBand(band);
+    
     reset();
 }
 
-void Equalizer::setSampleRate(double sampleRate) {
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = 512;
-    spec.numChannels = 2;
-    isPrepared = false;
-    updateFilters();
+template <typename SampleType>
+void Equalizer<SampleType>::reset() {
+    // Band settings survive a reset, like the compressor's and reverb's do
+    state1.fill(Vector::expand(0));
+    state2.fill(Vector::expand(0));
+    snapFilters();
 }
 
-void Equalizer::reset() {
-    filterChain.reset();
+template <typename SampleType>
+void Equalizer<SampleType>::setBand(size_t band, BandType type, float frequency, float gainDb, float q) {
+    jassert(band < maxBands);
+    const Band settings { type, frequency, gainDb, q };
     
-    // Initialize with flat response
-    double sampleRate = spec.sampleRate > 0 ? spec.sampleRate : 44100.0;
-    highShelfCoeffs = juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, 10000.0f, 1.0f, 1.0f);
-    midPeakCoeffs = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, 1000.0f, 1.0f, 1.0f);
-    lowShelfCoeffs = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, 100.0f, 1.0f, 1.0f);
+    // Unchanged bands keep their coefficients (and any ramp in progress)
+    if (bands[band] == settings) return;
     
-    updateFilters();
+    bands[band] = settings;
+    updateBand(band);
 }
 
-void Equalizer::setHighShelf(float frequency, float gainDb) {
-    float gain = juce::Decibels::decibelsToGain(gainDb);
-    double sampleRate = spec.sampleRate > 0 ? spec.sampleRate : 44100.0;
-    highShelfCoeffs = juce::dsp::IIR::Coefficients<float>::makeHighShelf(sampleRate, frequency, 1.0f, gain);
-    updateFilters();
+template <typename SampleType>
+void Equalizer<SampleType>::processBlock(juce::AudioBuffer<SampleType>& buffer) {
+    // Smaller blocks and fewer channels than prepared for are fine as they are
+    jassert(buffer.getNumSamples() <= (int)interleaved.size());
+    jassert(buffer.getNumChannels() <= (int)maxChannels);
+    
+    updateActiveBands();
+    if (numActiveBands == 0) return;
+    
+    const int numChannels = juce::jmin(buffer.getNumChannels(), (int)maxChannels);
+    auto* lanes = reinterpret_cast<SampleType*>(interleaved.data());
+    
+    // A host exceeding the prepared block size still gets filtered, in pieces
+    for (int start = 0; start < buffer.getNumSamples(); start += (int)interleaved.size()) {
+        const int numSamples = juce::jmin((int)interleaved.size(), buffer.getNumSamples() - start);
+        
+        // Channel c of sample i goes to lane c of interleaved[i]; unused lanes stay silent
+        for (size_t channel = 0; channel < maxChannels; ++channel) {
+            const SampleType* source = (int)channel < numChannels ? buffer.getReadPointer((int)channel, start) : nullptr;
+            for (int i = 0; i < numSamples; ++i)
+                lanes[(size_t)i * maxChannels + channel] = source != nullptr ? source[i] : SampleType(0);
+        }
+        
+        if (!isSmoothing()) {
+            for (size_t index = 0; index < numActiveBands; ++index)
+                processBand(activeBands[index], interleaved.data(), (size_t)numSamples);
+        } else {
+            // While a band is gliding, its coefficients move once per control interval
+            const int interval = ParameterSmoothing::controlInterval;
+            for (int offset = 0; offset < numSamples; offset += interval) {
+                const int length = juce::jmin(interval, numSamples - offset);
+                advanceRamps(length);
+                
+                for (size_t index = 0; index < numActiveBands; ++index)
+                    processBand(activeBands[index], interleaved.data() + offset, (size_t)length);
+            }
+        }
+        
+        for (int channel = 0; channel < numChannels; ++channel) {
+            SampleType* destination = buffer.getWritePointer(channel, start);
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = lanes[(size_t)i * maxChannels + (size_t)channel];
+        }
+    }
 }
 
-void Equalizer::setMidPeak(float frequency, float gainDb, float q) {
-    float gain = juce::Decibels::decibelsToGain(gainDb);
-    double sampleRate = spec.sampleRate > 0 ? spec.sampleRate : 44100.0;
-    midPeakCoeffs = juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate, frequency, q, gain);
-    updateFilters();
+template <typename SampleType>
+void Equalizer<SampleType>::processBand(size_t band, Vector* samples, size_t numSamples) {
+    const auto b0 = Vector::expand(coefficients.b0[band]);
+    const auto b1 = Vector::expand(coefficients.b1[band]);
+    const auto b2 = Vector::expand(coefficients.b2[band]);
+    const auto a1 = Vector::expand(coefficients.a1[band]);
+    const auto a2 = Vector::expand(coefficients.a2[band]);
+    
+    auto s1 = state1[band];
+    auto s2 = state2[band];
+    
+    for (size_t i = 0; i < numSamples; ++i) {
+        const auto x = samples[i];
+        const auto y = b0 * x + s1;
+        s1 = b1 * x - a1 * y + s2;
+        s2 = b2 * x - a2 * y;
+        samples[i] = y;
+    }
+    
+    state1[band] = s1;
+    state2[band] = s2;
 }
 
-void Equalizer::setLowShelf(float frequency, float gainDb) {
-    float gain = juce::Decibels::decibelsToGain(gainDb);
-    double sampleRate = spec.sampleRate > 0 ? spec.sampleRate : 44100.0;
-    lowShelfCoeffs = juce::dsp::IIR::Coefficients<float>::makeLowShelf(sampleRate, frequency, 1.0f, gain);
-    updateFilters();
+template <typename SampleType>
+bool Equalizer<SampleType>::isActive() const {
+    for (size_t band = 0; band < maxBands; ++band)
+        if (isBandActive(band))
+            return true;
+    
+    return false;
 }
 
-void Equalizer::processBlock(juce::AudioBuffer<float>& buffer) {
-    juce::dsp::ProcessSpec processSpec;
-    processSpec.sampleRate = spec.sampleRate > 0 ? spec.sampleRate : 44100.0;
-    processSpec.maximumBlockSize = (juce::uint32)buffer.getNumSamples();
-    processSpec.numChannels = (juce::uint32)buffer.getNumChannels();
+template <typename SampleType>
+bool Equalizer<SampleType>::isBandActive(size_t band) const {
+    return bands[band].gainDb != 0.0f || coefficientRamps[band].isSmoothing();
+}
+
+template <typename SampleType>
+void Equalizer<SampleType>::updateActiveBands() {
+    numActiveBands = 0;
     
-    prepareIfNeeded(processSpec);
+    for (size_t band = 0; band < maxBands; ++band) {
+        const bool active = isBandActive(band);
+        
+        // A flat band passes audio through unchanged and its state stays at
+        // zero, so a band waking up starts from cleared state
+        if (active && !bandActive[band]) {
+            state1[band] = Vector::expand(0);
+            state2[band] = Vector::expand(0);
+        }
+        
+        bandActive[band] = active;
+        if (active)
+            activeBands[numActiveBands++] = band;
+    }
+}
+
+template <typename SampleType>
+double Equalizer<SampleType>::getTailLengthSeconds() const {
+    double tail = 0.0;
+    for (size_t band = 0; band < maxBands; ++band)
+        if (isBandActive(band))
+            tail = juce::jmax(tail, getBandTailSeconds(bands[band].frequency, bands[band].q));
     
-    juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-    filterChain.process(context);
+    return tail;
 }
 
-void Equalizer::prepareIfNeeded(const juce::dsp::ProcessSpec& processSpec) {
-    if (!isPrepared || spec.sampleRate != processSpec.sampleRate || 
-        spec.maximumBlockSize != processSpec.maximumBlockSize || 
-        spec.numChannels != processSpec.numChannels) {
-        spec = processSpec;
-        filterChain.prepare(spec);
-        isPrepared = true;
-        updateFilters();
+template <typename SampleType>
+double Equalizer<SampleType>::getBandTailSeconds(float frequency, float q) {
+    // A resonance decays with time constant 2Q / w0; about 14 of those
+    // take it down by 120 dB
+    return 14.0 * q / (juce::MathConstants<double>::pi * juce::jmax(1.0f, frequency));
+}
+
+template <typename SampleType>
+void Equalizer<SampleType>::updateBand(size_t band) {
+    const auto& settings = bands[band];
+    
+    typename BiquadCoefficientRamp<SampleType>::Coefficients target;
+    switch (settings.type) {
+        case BandType::highShelf: BiquadDesign::makeHighShelf(target.data(), sampleRate, settings.frequency, settings.q, settings.gainDb); break;
+        case BandType::peak: BiquadDesign::makePeakFilter(target.data(), sampleRate, settings.frequency, settings.q, settings.gainDb); break;
+        case BandType::lowShelf: BiquadDesign::makeLowShelf(target.data(), sampleRate, settings.frequency, settings.q, settings.gainDb); break;
+    }
+    
+    coefficientRamps[band].setTarget(target);
+    
+    // Nothing is playing through the filters yet, so there is nothing to glide from
+    if (!isPrepared) {
+        coefficientRamps[band].snapToTarget();
+        writeCoefficients(band, coefficientRamps[band].getCurrent());
     }
 }
 
-void Equalizer::updateFilters() {
-    if (isPrepared && highShelfCoeffs && midPeakCoeffs && lowShelfCoeffs) {
-        *filterChain.get<0>().coefficients = *highShelfCoeffs;
-        *filterChain.get<1>().coefficients = *midPeakCoeffs;
-        *filterChain.get<2>().coefficients = *lowShelfCoeffs;
+template <typename SampleType>
+void Equalizer<SampleType>::snapFilters() {
+    for (size_t band = 0; band < maxBands; ++band) {
+        coefficientRamps[band].snapToTarget();
+        writeCoefficients(band, coefficientRamps[band].getCurrent());
     }
 }
 
+template <typename SampleType>
+void Equalizer<SampleType>::advanceRamps(int numSamples) {
+    for (size_t band = 0; band < maxBands; ++band)
+        if (coefficientRamps[band].isSmoothing())
+            writeCoefficients(band, coefficientRamps[band].advance(numSamples));
+}
+
+template <typename SampleType>
+void Equalizer<SampleType>::writeCoefficients(size_t band, const typename BiquadCoefficientRamp<SampleType>::Coefficients& newCoefficients) {
+    // b0, b1, b2, a1, a2, as BiquadDesign writes them
+    coefficients.b0[band] = newCoefficients[0];
+    coefficients.b1[band] = newCoefficients[1];
+    coefficients.b2[band] = newCoefficients[2];
+    coefficients.a1[band] = newCoefficients[3];
+    coefficients.a2[band] = newCoefficients[4];
+}
+
+template <typename SampleType>
+bool Equalizer<SampleType>::isSmoothing() const {
+    for (const auto& ramp : coefficientRamps)
+        if (ramp.isSmoothing())
+            return true;
+    
+    return false;
+}
+
+template class Equalizer<float>;
+template class Equalizer<double>;
@@ -2,36 +2,96 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "ParameterSmoothing.h"
+#include <array>
+#include <vector>
 
+// Up to maxBands shelves and peaks in series. The bands' coefficients and
+// states are kept as structure-of-arrays, and every channel runs through
+// the cascade at once: channels sit side by side in the lanes of a
+// juce::dsp::SIMDRegister, so one SIMD biquad per band and sample filters
+// them all. Flat bands are skipped entirely.
+//
+// Instantiated for float and double; double processing carries half as many
+// lanes per register, which still covers a stereo pair.
+template <typename SampleType>
 class Equalizer {
 public:
+    enum class BandType {
+        lowShelf,
+        peak,
+        highShelf
+    };
+    
+    static constexpr size_t maxBands = 8;
+    
     Equalizer();
     
-    void setSampleRate(double sampleRate);
+    // Sets up the filters for the host's sample rate, largest block and
+    // channel count; the only place memory is allocated
+    void prepare(const juce::dsp::ProcessSpec& processSpec);
     void reset();
     
-    // EQ Parameters
-    void setHighShelf(float frequency, float gainDb);
-    void setMidPeak(float frequency, float gainDb, float q);
-    void setLowShelf(float frequency, float gainDb);
+    // Every band starts out as a flat peak. For shelves q sets the slope,
+    // 1 being the usual one
+    void setBand(size_t band, BandType type, float frequency, float gainDb, float q = 1.0f);
+    
+    void processBlock(juce::AudioBuffer<SampleType>& buffer);
     
-    void processBlock(juce::AudioBuffer<float>& buffer);
+    // False while every band is flat; processBlock is then a no-op
+    bool isActive() const;
+    
+    // How long the active bands keep ringing after the input goes silent
+    double getTailLengthSeconds() const;
+    
+    // Ring time of one band, down to -120 dB
+    static double getBandTailSeconds(float frequency, float q);
     
 private:
-    juce::dsp::ProcessorChain<
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>,
-        juce::dsp::IIR::Filter<float>
-    > filterChain;
+    using Vector = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr size_t maxChannels = Vector::SIMDNumElements;
+    
+    struct Band {
+        BandType type;
+        float frequency;
+        float gainDb;
+        float q;
+        
+        bool operator==(const Band& other) const {
+            return type == other.type && frequency == other.frequency && gainDb == other.gainDb && q == other.q;
+        }
+    };
     
-    juce::dsp::IIR::Coefficients<float>::Ptr highShelfCoeffs;
-    juce::dsp::IIR::Coefficients<float>::Ptr midPeakCoeffs;
-    juce::dsp::IIR::Coefficients<float>::Ptr lowShelfCoeffs;
+    // Flat until told otherwise
+    std::array<Band, maxBands> bands;
+    std::array<BiquadCoefficientRamp<SampleType>, maxBands> coefficientRamps;
     
-    juce::dsp::ProcessSpec spec;
+    // Current coefficients, one array per term, written from the ramps
+    struct Coefficients {
+        std::array<SampleType, maxBands> b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+    } coefficients;
+    
+    // Transposed direct form II state, one lane per channel
+    std::array<Vector, maxBands> state1 {};
+    std::array<Vector, maxBands> state2 {};
+    
+    // Bands that currently do something, in cascade order
+    std::array<bool, maxBands> bandActive {};
+    std::array<size_t, maxBands> activeBands {};
+    size_t numActiveBands = 0;
+    
+    // The block with channels interleaved into SIMD lanes
+    std::vector<Vector> interleaved;
+    
+    double sampleRate = 44100.0;
     bool isPrepared = false;
     
-    void updateFilters();
-    void prepareIfNeeded(const juce::dsp::ProcessSpec& processSpec);
+    void updateBand(size_t band);
+    void snapFilters();
+    void advanceRamps(int numSamples);
+    void writeCoefficients(size_t band, const typename BiquadCoefficientRamp<SampleType>::Coefficients& newCoefficients);
+    bool isSmoothing() const;
+    bool isBandActive(size_t band) const;
+    void updateActiveBands();
+    void processBand(size_t band, Vector* samples, size_t numSamples);
 };
-
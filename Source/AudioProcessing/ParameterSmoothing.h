@@ -0,0 +1,106 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+
+// Shared by Equalizer, Compressor and ReverbProcessor so every parameter
+// change glides over the same time instead of jumping between blocks.
+// Nothing in here allocates; ramps are set up in prepare().
+namespace ParameterSmoothing {
+    // Length of every parameter ramp
+    constexpr double rampLengthSeconds = 0.05;
+
+    // While a ramp is running, per-block state (filter coefficients) is
+    // refreshed at most this many samples apart
+    constexpr int controlInterval = 32;
+}
+
+// juce::SmoothedValue with the ramp length fixed to the shared one and a
+// helper that renders a run of values for vectorised consumers.
+class SmoothedParameter {
+public:
+    explicit SmoothedParameter(float initialValue = 0.0f) {
+        value.setCurrentAndTargetValue(initialValue);
+    }
+
+    void reset(double sampleRate) {
+        value.reset(sampleRate, ParameterSmoothing::rampLengthSeconds);
+    }
+
+    void setTarget(float newTarget) { value.setTargetValue(newTarget); }
+    void snapToTarget() { value.setCurrentAndTargetValue(value.getTargetValue()); }
+
+    bool isSmoothing() const noexcept { return value.isSmoothing(); }
+    float getCurrent() const noexcept { return value.getCurrentValue(); }
+    float getTarget() const noexcept { return value.getTargetValue(); }
+
+    // Writes the next numSamples values of the ramp to dest
+    void fill(float* dest, int numSamples) {
+        if (!value.isSmoothing()) {
+            juce::FloatVectorOperations::fill(dest, value.getTargetValue(), numSamples);
+            return;
+        }
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = value.getNextValue();
+    }
+
+private:
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> value;
+};
+
+// Linear ramp between two sets of normalised biquad coefficients
+// (b0, b1, b2, a1, a2), in the filter's sample type. Stable second-order
+// sections form a convex region of (a1, a2), so every point along the ramp is
+// a stable filter as well.
+template <typename SampleType>
+class BiquadCoefficientRamp {
+public:
+    using Coefficients = std::array<SampleType, 5>;
+
+    void reset(double sampleRate) {
+        rampLength = juce::jmax(1, juce::roundToInt(sampleRate * ParameterSmoothing::rampLengthSeconds));
+        current = target;
+        remaining = 0;
+    }
+
+    void setTarget(const Coefficients& newTarget) {
+        if (newTarget == target) return;
+
+        target = newTarget;
+        remaining = rampLength;
+
+        const SampleType scale = SampleType(1) / (SampleType)rampLength;
+        for (size_t i = 0; i < step.size(); ++i)
+            step[i] = (target[i] - current[i]) * scale;
+    }
+
+    void snapToTarget() {
+        current = target;
+        remaining = 0;
+    }
+
+    bool isSmoothing() const noexcept { return remaining > 0; }
+    const Coefficients& getCurrent() const noexcept { return current; }
+
+    // Moves numSamples along the ramp and returns the coefficients to use
+    const Coefficients& advance(int numSamples) {
+        if (remaining <= numSamples) {
+            snapToTarget();
+            return current;
+        }
+
+        remaining -= numSamples;
+        for (size_t i = 0; i < current.size(); ++i)
+            current[i] += step[i] * (SampleType)numSamples;
+
+        return current;
+    }
+
+private:
+    Coefficients current { 1, 0, 0, 0, 0 };
+    Coefficients target { 1, 0, 0, 0, 0 };
+    Coefficients step {};
+    int rampLength = 1;
+    int remaining = 0;
+};
@@ -0,0 +1,128 @@
+#include "ProcessingChain.h"
+#include <type_traits>
+
+template <typename SampleType>
+void ProcessingChain<SampleType>::prepare(const juce::dsp::ProcessSpec& spec) {
+    sampleRate = spec.sampleRate;
+    
+    equalizer.prepare(spec);
+    compressor.prepare(spec);
+    reverbProcessor.prepare(spec, std::is_same_v<SampleType, double>);
+    
+    reset();
+}
+
+template <typename SampleType>
+void ProcessingChain<SampleType>::reset() {
+    silentSamples = 0;
+    quietSamples = 0;
+    sleeping = false;
+    
+    equalizer.reset();
+    compressor.reset();
+    reverbProcessor.reset();
+}
+
+template <typename SampleType>
+void ProcessingChain<SampleType>::setParameters(const AudioParameters& params) {
+    // Apply EQ settings; every band is fully specified, so bands that
+    // didn't change are skipped inside the Equalizer
+    equalizer.setBand(lowShelfBand, EqualizerType::BandType::lowShelf, params.eq.lowShelfFreq, params.eq.lowShelfGain);
+    equalizer.setBand(lowMidBand, EqualizerType::BandType::peak, params.eq.lowMidFreq, params.eq.lowMidGain, params.eq.lowMidQ);
+    equalizer.setBand(midBand, EqualizerType::BandType::peak, params.eq.midFreq, params.eq.midGain, params.eq.midQ);
+    equalizer.setBand(highShelfBand, EqualizerType::BandType::highShelf, params.eq.highShelfFreq, params.eq.highShelfGain);
+    
+    // Apply compressor settings
+    compressor.setThreshold(params.compressor.threshold);
+    compressor.setRatio(params.compressor.ratio);
+    compressor.setAttack(params.compressor.attack);
+    compressor.setRelease(params.compressor.release);
+    compressor.setMakeupGain(params.compressor.makeupGain);
+    compressor.setEnabled(params.compressor.enabled);
+    
+    // Apply reverb settings
+    reverbProcessor.setRoomSize(params.reverb.roomSize);
+    reverbProcessor.setDamping(params.reverb.damping);
+    reverbProcessor.setWidth(params.reverb.width);
+    reverbProcessor.setWetLevel(params.reverb.wetLevel);
+    reverbProcessor.setDryLevel(params.reverb.dryLevel);
+    reverbProcessor.setEnabled(params.reverb.enabled);
+}
+
+template <typename SampleType>
+void ProcessingChain<SampleType>::processBlock(juce::AudioBuffer<SampleType>& buffer) {
+    // Nothing would change the audio, so there's no tail to account for either
+    if (!isActive()) return;
+    
+    const bool inputSilent = isSilent(buffer);
+    
+    if (!inputSilent) {
+        silentSamples = 0;
+        quietSamples = 0;
+        sleeping = false;
+    } else if (sleeping) {
+        compressor.skipSilence(buffer.getNumSamples());
+        return;
+    } else if (silentSamples >= (juce::int64)(getTailLengthSeconds() * sampleRate)
+               || quietSamples >= (juce::int64)(quietSecondsToSleep * sampleRate)) {
+        // The tail has rung out. Clear what's left of the EQ and reverb's so
+        // the next sound starts from silence, exactly as if we had kept
+        // processing. The compressor's envelope may still be releasing,
+        // which it keeps doing while we sleep
+        equalizer.reset();
+        reverbProcessor.reset();
+        compressor.skipSilence(buffer.getNumSamples());
+        sleeping = true;
+        return;
+    } else {
+        silentSamples += buffer.getNumSamples();
+    }
+    
+    equalizer.processBlock(buffer);
+    compressor.processBlock(buffer);
+    reverbProcessor.processBlock(buffer);
+    
+    // Track the tail's actual decay, which usually ends well before the
+    // worst case getTailLengthSeconds() allows for
+    if (inputSilent)
+        quietSamples = isSilent(buffer) ? quietSamples + buffer.getNumSamples() : 0;
+}
+
+template <typename SampleType>
+bool ProcessingChain<SampleType>::isActive() const {
+    return equalizer.isActive() || compressor.isActive() || reverbProcessor.isActive();
+}
+
+template <typename SampleType>
+double ProcessingChain<SampleType>::getTailLengthSeconds() const {
+    // The compressor only scales what comes in, so it adds no tail
+    return equalizer.getTailLengthSeconds() + reverbProcessor.getTailLengthSeconds();
+}
+
+template <typename SampleType>
+double ProcessingChain<SampleType>::getTailLengthSeconds(const AudioParameters& params) {
+    double eqTail = 0.0;
+    if (params.eq.highShelfGain != 0.0f)
+        eqTail = juce::jmax(eqTail, EqualizerType::getBandTailSeconds(params.eq.highShelfFreq, 1.0f));
+    if (params.eq.midGain != 0.0f)
+        eqTail = juce::jmax(eqTail, EqualizerType::getBandTailSeconds(params.eq.midFreq, params.eq.midQ));
+    if (params.eq.lowMidGain != 0.0f)
+        eqTail = juce::jmax(eqTail, EqualizerType::getBandTailSeconds(params.eq.lowMidFreq, params.eq.lowMidQ));
+    if (params.eq.lowShelfGain != 0.0f)
+        eqTail = juce::jmax(eqTail, EqualizerType::getBandTailSeconds(params.eq.lowShelfFreq, 1.0f));
+    
+    const double reverbTail = params.reverb.enabled ? ReverbProcessor::getTailLengthSeconds(params.reverb.roomSize) : 0.0;
+    return eqTail + reverbTail;
+}
+
+template <typename SampleType>
+bool ProcessingChain<SampleType>::isSilent(const juce::AudioBuffer<SampleType>& buffer) {
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        if (buffer.getMagnitude(channel, 0, buffer.getNumSamples()) > silenceThreshold)
+            return false;
+    
+    return true;
+}
+
+template class ProcessingChain<float>;
+template class ProcessingChain<double>;
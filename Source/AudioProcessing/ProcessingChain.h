@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Equalizer.h"
+#include "Compressor.h"
+#include "ReverbProcessor.h"
+#include "../AudioParameters.h"
+
+// EQ -> compressor -> reverb, configured from one AudioParameters snapshot.
+// The plugin and the offline renderer both run audio through this, so they
+// always sound the same. Instantiated for float and double buffers.
+template <typename SampleType>
+class ProcessingChain {
+public:
+    // Everything is allocated and sized here, for blocks of up to
+    // maximumBlockSize samples; processBlock never re-prepares
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    
+    // Clears filter, detector and reverb state and jumps straight to the
+    // current settings instead of gliding to them
+    void reset();
+    
+    void setParameters(const AudioParameters& params);
+    
+    // Skips everything when no processor is active, and once the input has
+    // been silent for longer than the chain's tail; the compressor's
+    // envelope still releases through skipped silence
+    void processBlock(juce::AudioBuffer<SampleType>& buffer);
+    
+    // False when every processor would pass audio through unchanged
+    bool isActive() const;
+    
+    // How long the output can keep sounding after the input goes silent
+    double getTailLengthSeconds() const;
+    
+    // The same for a chain set to params, without needing the chain; safe
+    // to call from any thread
+    static double getTailLengthSeconds(const AudioParameters& params);
+    
+    // True once the input has gone silent and the tail has decayed; the
+    // chain then skips processing until sound comes in again
+    bool isSleeping() const { return sleeping; }
+    
+private:
+    // Which Equalizer band each AudioParameters band drives
+    static constexpr size_t lowShelfBand = 0;
+    static constexpr size_t lowMidBand = 1;
+    static constexpr size_t midBand = 2;
+    static constexpr size_t highShelfBand = 3;
+    
+    using EqualizerType = Equalizer<SampleType>;
+    
+    EqualizerType equalizer;
+    Compressor compressor;
+    ReverbProcessor reverbProcessor;
+    
+    // Input quieter than this (-120 dB) on every channel counts as silence
+    static constexpr float silenceThreshold = 1.0e-6f;
+    
+    // Output that stays below the silence threshold for this long has
+    // decayed for good, even if the computed tail isn't over yet. Longer
+    // than the reverb's comb loops, so a tail can't hide between echoes
+    static constexpr double quietSecondsToSleep = 0.05;
+    
+    double sampleRate = 44100.0;
+    juce::int64 silentSamples = 0;   // since the input went silent
+    juce::int64 quietSamples = 0;    // since the output went silent as well
+    bool sleeping = false;
+    
+    static bool isSilent(const juce::AudioBuffer<SampleType>& buffer);
+};
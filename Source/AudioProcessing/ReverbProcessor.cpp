@@ -1,19 +1,30 @@
 #include "ReverbProcessor.h"
+#include <cmath>
 
 ReverbProcessor::ReverbProcessor() {
+    // Usable straight away; the host's prepareToPlay replaces this
+    prepare(spec);
     reset();
 }
 
-void ReverbProcessor::setSampleRate(double sampleRate) {
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = 512;
-    spec.numChannels = 2;
-    isPrepared = false;
+void ReverbProcessor::prepare(const juce::dsp::ProcessSpec& processSpec, bool doublePrecision) {
+    mix.reset(processSpec.sampleRate);
+    dryGain.reset(processSpec.sampleRate);
+    spec = processSpec;
+    mixesDry = doublePrecision;
+    
+    // Settings first, so the reverb's gains start where they should
+    updateReverbSettings();
+    reverb.prepare(spec);
+    conversionBuffer.setSize((int)spec.numChannels, doublePrecision ? chunkSize : 0);
 }
 
 void ReverbProcessor::reset() {
     reverb.reset();
+    mix.setTarget(enabled ? 1.0f : 0.0f);
+    mix.snapToTarget();
     updateReverbSettings();
+    dryGain.snapToTarget();
 }
 
 void ReverbProcessor::setRoomSize(float r) {
@@ -42,33 +53,108 @@ void ReverbProcessor::setDryLevel(float dry) {
 }
 
 void ReverbProcessor::setEnabled(bool en) {
+    // Coming back from idle: drop whatever tail was left in the tank
+    if (en && !enabled && mix.getCurrent() == 0.0f)
+        reverb.reset();
+    
     enabled = en;
+    mix.setTarget(enabled ? 1.0f : 0.0f);
+}
+
+bool ReverbProcessor::isActive() const {
+    return enabled || mix.isSmoothing();
+}
+
+double ReverbProcessor::getTailLengthSeconds() const {
+    return isActive() ? getTailLengthSeconds(roomSize, 120.0) : 0.0;
+}
+
+double ReverbProcessor::getTailLengthSeconds(float roomSize, double decayDb) {
+    // Every trip round the longest comb scales what's left by its feedback
+    const double feedback = juce::jlimit(0.0f, 1.0f, roomSize) * combFeedbackScale + combFeedbackOffset;
+    const double trips = (-decayDb / 20.0) * std::log(10.0) / std::log(feedback);
+    return trips * longestCombSeconds;
 }
 
 void ReverbProcessor::processBlock(juce::AudioBuffer<float>& buffer) {
-    if (!enabled) return;
+    if (!isActive()) return;
     
-    juce::dsp::ProcessSpec processSpec;
-    processSpec.sampleRate = spec.sampleRate > 0 ? spec.sampleRate : 44100.0;
-    processSpec.maximumBlockSize = (juce::uint32)buffer.getNumSamples();
-    processSpec.numChannels = (juce::uint32)buffer.getNumChannels();
-    
-    prepareIfNeeded(processSpec);
+    // Smaller blocks and fewer channels than prepared for are fine as they are
+    jassert(buffer.getNumSamples() <= (int)spec.maximumBlockSize);
+    jassert(buffer.getNumChannels() <= (int)spec.numChannels);
     
     juce::dsp::AudioBlock<float> block(buffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
     
+    if (mix.isSmoothing()) {
+        processCrossfade(block);
+        return;
+    }
+    
+    juce::dsp::ProcessContextReplacing<float> context(block);
     reverb.process(context);
 }
 
-void ReverbProcessor::prepareIfNeeded(const juce::dsp::ProcessSpec& processSpec) {
-    if (!isPrepared || spec.sampleRate != processSpec.sampleRate || 
-        spec.maximumBlockSize != processSpec.maximumBlockSize || 
-        spec.numChannels != processSpec.numChannels) {
-        spec = processSpec;
-        reverb.prepare(spec);
-        isPrepared = true;
-        updateReverbSettings();
+void ReverbProcessor::processBlock(juce::AudioBuffer<double>& buffer) {
+    if (!isActive()) return;
+    
+    // Only a chain prepared for double buffers has the reverb set to wet only
+    jassert(mixesDry);
+    jassert(buffer.getNumSamples() <= (int)spec.maximumBlockSize);
+    jassert(buffer.getNumChannels() <= conversionBuffer.getNumChannels());
+    
+    const int numChannels = juce::jmin(buffer.getNumChannels(), conversionBuffer.getNumChannels());
+    
+    for (int start = 0; start < buffer.getNumSamples(); start += chunkSize) {
+        const int numSamples = juce::jmin(chunkSize, buffer.getNumSamples() - start);
+        
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const double* source = buffer.getReadPointer(channel, start);
+            float* destination = conversionBuffer.getWritePointer(channel);
+            for (int i = 0; i < numSamples; ++i)
+                destination[i] = (float)source[i];
+        }
+        
+        juce::dsp::AudioBlock<float> block(conversionBuffer.getArrayOfWritePointers(), (size_t)numChannels, (size_t)numSamples);
+        juce::dsp::ProcessContextReplacing<float> context(block);
+        reverb.process(context);
+        
+        mix.fill(mixBuffer.data(), numSamples);
+        dryGain.fill(dryGainBuffer.data(), numSamples);
+        
+        // out = dry + mix * (wet + dryGain * dry - dry), the dry terms in double
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const float* wet = conversionBuffer.getReadPointer(channel);
+            double* samples = buffer.getWritePointer(channel, start);
+            for (int i = 0; i < numSamples; ++i) {
+                const double dry = samples[i];
+                const double processed = (double)wet[i] + ((double)dryGainBuffer[(size_t)i] - 1.0) * dry;
+                samples[i] = dry + (double)mixBuffer[(size_t)i] * processed;
+            }
+        }
+    }
+}
+
+void ReverbProcessor::processCrossfade(juce::dsp::AudioBlock<float>& block) {
+    const size_t numChannels = juce::jmin(block.getNumChannels(), (size_t)maxChannels);
+    
+    for (size_t start = 0; start < block.getNumSamples(); start += (size_t)chunkSize) {
+        const size_t numSamples = juce::jmin((size_t)chunkSize, block.getNumSamples() - start);
+        auto subBlock = block.getSubBlock(start, numSamples);
+        
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::copy(dryBuffers[channel].data(), subBlock.getChannelPointer(channel), (int)numSamples);
+        
+        juce::dsp::ProcessContextReplacing<float> context(subBlock);
+        reverb.process(context);
+        
+        // out = dry + mix * (wet - dry)
+        mix.fill(mixBuffer.data(), (int)numSamples);
+        for (size_t channel = 0; channel < numChannels; ++channel) {
+            auto* wet = subBlock.getChannelPointer(channel);
+            juce::FloatVectorOperations::subtract(wet, dryBuffers[channel].data(), (int)numSamples);
+            juce::FloatVectorOperations::multiply(wet, mixBuffer.data(), (int)numSamples);
+            juce::FloatVectorOperations::add(wet, dryBuffers[channel].data(), (int)numSamples);
+        }
     }
 }
 
@@ -78,7 +164,9 @@ void ReverbProcessor::updateReverbSettings() {
     params.damping = damping;
     params.width = width;
     params.wetLevel = wetLevel;
-    params.dryLevel = dryLevel;
+    params.dryLevel = mixesDry ? 0.0f : dryLevel;
     reverb.setParameters(params);
+    
+    dryGain.setTarget(dryLevel * dryScaleFactor);
 }
 
@@ -2,12 +2,17 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
+#include "ParameterSmoothing.h"
+#include <array>
 
 class ReverbProcessor {
 public:
     ReverbProcessor();
     
-    void setSampleRate(double sampleRate);
+    // Sets up the reverb for the host's sample rate, largest block and
+    // channel count; the only place its tank is cleared apart from reset().
+    // doublePrecision says which processBlock the caller will use
+    void prepare(const juce::dsp::ProcessSpec& processSpec, bool doublePrecision = false);
     void reset();
     
     // Reverb Parameters
@@ -20,6 +25,23 @@ public:
     
     void processBlock(juce::AudioBuffer<float>& buffer);
     
+    // juce::dsp::Reverb only runs in float, so for double buffers it is fed
+    // a float copy and set to produce the wet signal alone; the dry signal,
+    // its level and the on/off crossfade are mixed in at double precision.
+    // Needs prepare() with doublePrecision set
+    void processBlock(juce::AudioBuffer<double>& buffer);
+    
+    // False once disabled and faded out; processBlock is then a no-op
+    bool isActive() const;
+    
+    // How long the reverb can keep sounding after its input goes silent
+    double getTailLengthSeconds() const;
+    
+    // Time for a reverb of this room size to decay by decayDb. Damping only
+    // shortens the high end (the comb lowpass has unity gain at DC), so the
+    // low end, and with it the tail, depends on room size alone
+    static double getTailLengthSeconds(float roomSize, double decayDb = 120.0);
+    
 private:
     juce::dsp::Reverb reverb;
     
@@ -30,10 +52,36 @@ private:
     float dryLevel = 1.0f;
     bool enabled = false;
     
-    juce::dsp::ProcessSpec spec;
-    bool isPrepared = false;
+    juce::dsp::ProcessSpec spec { 44100.0, 512, 2 };
+    
+    // Set for double buffers: juce::Reverb's dry level is held at 0 and
+    // dryGain is applied here instead
+    bool mixesDry = false;
+    
+    // juce::Reverb scales dryLevel by 2 before applying it
+    static constexpr float dryScaleFactor = 2.0f;
+    
+    // juce::Reverb's comb feedback is roomSize * 0.28 + 0.7, and its longest
+    // comb (right channel) is 1617 + 23 samples at 44.1 kHz, scaled with the
+    // sample rate, so its decay time doesn't depend on the rate
+    static constexpr float combFeedbackScale = 0.28f;
+    static constexpr float combFeedbackOffset = 0.7f;
+    static constexpr double longestCombSeconds = 1640.0 / 44100.0;
+    
+    // juce::Reverb already smooths its own gains and damping; what's left is
+    // switching it on and off, which crossfades against the dry signal here
+    SmoothedParameter mix;
+    SmoothedParameter dryGain;
+    static constexpr int chunkSize = 256;
+    static constexpr int maxChannels = 2;
+    std::array<std::array<float, chunkSize>, maxChannels> dryBuffers {};
+    std::array<float, chunkSize> mixBuffer {};
+    std::array<float, chunkSize> dryGainBuffer {};
+    
+    // Float copy of one chunk of a double block, sized in prepare()
+    juce::AudioBuffer<float> conversionBuffer;
     
+    void processCrossfade(juce::dsp::AudioBlock<float>& block);
     void updateReverbSettings();
-    void prepareIfNeeded(const juce::dsp::ProcessSpec& processSpec);
 };
 
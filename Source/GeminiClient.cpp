@@ -1,13 +1,42 @@
 #include "GeminiClient.h"
+#include "GeminiResponseParser.h"
 #include <juce_core/juce_core.h>
 
-GeminiClient::GeminiClient() : Thread("GeminiAPIThread")
+namespace
+{
+    // Using Gemini 1.5 Flash (free tier) for faster responses
+    const char* const geminiEndpoint = "https://generativelanguage.googleapis.com/v1beta/models/gemini-1.5-flash:generateContent";
+}
+
+GeminiClient::GeminiClient() : Thread("GeminiAPIThread"), endpoint(geminiEndpoint)
 {
     startThread();
 }
 
 GeminiClient::~GeminiClient()
 {
+    signalThreadShouldExit();
+    
+    // Abort whatever is in flight so we don't sit out its timeout
+    std::vector<std::unique_ptr<juce::ThreadPool>> pools;
+    {
+        const juce::ScopedLock lock(requestLock);
+        startNewGeneration();
+        
+        for (auto* stream : openStreams)
+            stream->cancel();
+        
+        pools = std::move(retiredPools);
+        pools.push_back(std::move(requestPool));
+    }
+    
+    // Queued requests that haven't started are dropped without a callback
+    for (auto& pool : pools)
+        if (pool != nullptr)
+            pool->removeAllJobs(true, 5000);
+    pools.clear();
+    
+    requestReady.signal();
     stopThread(5000); // Wait up to 5 seconds for thread to finish
 }
 
@@ -16,6 +45,39 @@ void GeminiClient::setApiKey(const juce::String& key)
     apiKey = key.trim();
 }
 
+void GeminiClient::setEndpoint(const juce::String& generateContentUrl)
+{
+    {
+        const juce::ScopedLock lock(requestLock);
+        endpoint = generateContentUrl.isNotEmpty() ? generateContentUrl.trim() : getDefaultEndpoint();
+    }
+    
+    // Responses from another server aren't interchangeable with these
+    responseCache.setPersistentFile(persistentCacheFile, getCacheFingerprint());
+}
+
+juce::String GeminiClient::getEndpoint() const
+{
+    const juce::ScopedLock lock(requestLock);
+    return endpoint;
+}
+
+juce::String GeminiClient::getDefaultEndpoint()
+{
+    return geminiEndpoint;
+}
+
+void GeminiClient::setPersistentCacheFile(const juce::File& file)
+{
+    persistentCacheFile = file;
+    responseCache.setPersistentFile(persistentCacheFile, getCacheFingerprint());
+}
+
+juce::String GeminiClient::getCacheFingerprint()
+{
+    return juce::String::toHexString((getEndpoint() + buildPrompt({})).hashCode64());
+}
+
 void GeminiClient::processTextAsync(const juce::String& userInput, ResponseCallback callback)
 {
     if (!isApiKeySet())
@@ -25,22 +87,63 @@ void GeminiClient::processTextAsync(const juce::String& userInput, ResponseCallb
         return;
     }
     
+    // Text we've already processed is answered straight away; anything
+    // queued or in flight is older than this, so it is dropped
+    juce::String cachedText;
+    if (responseCache.lookup(userInput, cachedText))
+    {
+        {
+            const juce::ScopedLock lock(requestLock);
+            startNewGeneration();
+        }
+        
+        if (callback)
+            callback(true, cachedText, "");
+        return;
+    }
+    
     // Ensure thread is running
     if (!isThreadRunning())
     {
         startThread();
     }
     
+    // The newest text replaces whatever was waiting and aborts the request
+    // in flight, so the worker moves on to it as soon as possible
     {
         const juce::ScopedLock lock(requestLock);
-        currentRequest.input = userInput;
-        currentRequest.callback = callback;
+        pendingRequest.generation = startNewGeneration();
+        pendingRequest.input = userInput;
+        pendingRequest.callback = callback;
         hasRequest = true;
     }
     
     requestReady.signal();
 }
 
+void GeminiClient::cancelPendingRequests()
+{
+    const juce::ScopedLock lock(requestLock);
+    startNewGeneration();
+}
+
+juce::int64 GeminiClient::startNewGeneration()
+{
+    ++latestGeneration;
+    hasRequest = false;
+    
+    if (activeStream != nullptr)
+        activeStream->cancel();
+    
+    return latestGeneration;
+}
+
+bool GeminiClient::isLatestGeneration(juce::int64 generation)
+{
+    const juce::ScopedLock lock(requestLock);
+    return generation == latestGeneration;
+}
+
 bool GeminiClient::processTextSync(const juce::String& userInput, juce::String& processedText)
 {
     if (!isApiKeySet())
@@ -50,15 +153,207 @@ bool GeminiClient::processTextSync(const juce::String& userInput, juce::String&
         return false;
     }
     
-    return makeGeminiRequest(userInput, processedText);
+    if (responseCache.lookup(userInput, processedText))
+        return true;
+    
+    juce::String error;
+    const bool success = makeGeminiRequest(userInput, processedText, error);
+    lastError = error;
+    
+    if (!success)
+        return false;
+    
+    responseCache.store(userInput, processedText);
+    return true;
+}
+
+bool GeminiClient::processTextsSync(const juce::StringArray& inputs, juce::StringArray& processedTexts,
+                                    juce::Array<bool>& succeeded, int maxPromptsPerRequest)
+{
+    processedTexts = inputs;
+    succeeded.clearQuick();
+    succeeded.insertMultiple(0, false, inputs.size());
+    
+    if (!isApiKeySet())
+    {
+        lastError = "API key not set";
+        return false;
+    }
+    
+    // Cached inputs are answered here; only the rest go to the network
+    juce::Array<int> uncached;
+    for (int i = 0; i < inputs.size(); ++i)
+    {
+        juce::String cachedText;
+        if (responseCache.lookup(inputs[i], cachedText))
+        {
+            processedTexts.set(i, cachedText);
+            succeeded.set(i, true);
+        }
+        else
+        {
+            uncached.add(i);
+        }
+    }
+    
+    lastError.clear();
+    const int groupSize = juce::jmax(1, maxPromptsPerRequest);
+    
+    for (int first = 0; first < uncached.size(); first += groupSize)
+    {
+        const int count = juce::jmin(groupSize, uncached.size() - first);
+        
+        juce::StringArray group;
+        for (int i = 0; i < count; ++i)
+            group.add(inputs[uncached[first + i]]);
+        
+        juce::StringArray answers;
+        juce::String responseText, error;
+        
+        if (count == 1)
+        {
+            juce::String answer;
+            if (!makeGeminiRequest(group[0], answer, error))
+            {
+                lastError = error;
+                continue;
+            }
+            answers.add(answer);
+        }
+        else if (!sendPrompt(buildBatchPrompt(group), juce::jmin(8192, 100 + 80 * count), responseText, error))
+        {
+            // The whole group failed; retrying its inputs one by one would
+            // most likely fail the same way, just more slowly
+            lastError = error;
+            continue;
+        }
+        else if (!splitBatchResponse(responseText, count, answers))
+        {
+            // An answer we can't split; fall back to one request per input
+            answers.clearQuick();
+            for (const auto& input : group)
+            {
+                juce::String answer;
+                if (!makeGeminiRequest(input, answer, error))
+                    lastError = error;
+                answers.add(answer);
+            }
+        }
+        
+        for (int i = 0; i < count; ++i)
+        {
+            const auto& answer = answers[i];
+            if (answer.isEmpty() || answer.contains("[INVALID]"))
+                continue;
+            
+            const int index = uncached[first + i];
+            processedTexts.set(index, answer);
+            succeeded.set(index, true);
+            responseCache.store(inputs[index], answer);
+        }
+    }
+    
+    return !succeeded.contains(false);
+}
+
+void GeminiClient::enqueueTextAsync(const juce::String& userInput, TimedResponseCallback callback)
+{
+    const auto queuedAt = juce::Time::getHighResolutionTicks();
+    auto millisecondsSince = [](juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - ticks) * 1000.0;
+    };
+    
+    RequestTiming timing;
+    
+    if (!isApiKeySet())
+    {
+        if (callback)
+            callback(false, userInput, "API key not set. Please configure your Gemini API key.", timing);
+        return;
+    }
+    
+    juce::String cachedText;
+    if (responseCache.lookup(userInput, cachedText))
+    {
+        timing.fromCache = true;
+        timing.totalMs = millisecondsSince(queuedAt);
+        if (callback)
+            callback(true, cachedText, "", timing);
+        return;
+    }
+    
+    const juce::ScopedLock lock(requestLock);
+    
+    if (requestPool == nullptr)
+        requestPool = std::make_unique<juce::ThreadPool>(maxConcurrentRequests);
+    
+    requestPool->addJob([this, userInput, callback, queuedAt, millisecondsSince]
+    {
+        RequestTiming jobTiming;
+        jobTiming.queuedMs = millisecondsSince(queuedAt);
+        
+        juce::String processedText, error;
+        const bool success = makeGeminiRequest(userInput, processedText, error, 0, &jobTiming);
+        
+        if (success)
+            responseCache.store(userInput, processedText);
+        
+        jobTiming.totalMs = millisecondsSince(queuedAt);
+        if (callback)
+            callback(success, success ? processedText : userInput, error, jobTiming);
+    });
+}
+
+void GeminiClient::setMaxConcurrentRequests(int numRequests)
+{
+    std::vector<std::unique_ptr<juce::ThreadPool>> finishedPools;
+    {
+        const juce::ScopedLock lock(requestLock);
+        numRequests = juce::jmax(1, numRequests);
+        if (numRequests == maxConcurrentRequests)
+            return;
+        
+        maxConcurrentRequests = numRequests;
+        
+        // The next enqueueTextAsync starts a pool of the new size. The old
+        // one keeps working through what it was given, in the background,
+        // so every queued request still gets its callback
+        if (requestPool != nullptr)
+            retiredPools.push_back(std::move(requestPool));
+        
+        // Pools retired earlier that have run dry can go now
+        for (auto it = retiredPools.begin(); it != retiredPools.end();)
+        {
+            if ((*it)->getNumJobs() == 0)
+            {
+                finishedPools.push_back(std::move(*it));
+                it = retiredPools.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    
+    // Idle pools stop their threads straight away; outside the lock all the
+    // same, since stopping waits for them
+    finishedPools.clear();
+}
+
+int GeminiClient::getMaxConcurrentRequests() const
+{
+    const juce::ScopedLock lock(requestLock);
+    return maxConcurrentRequests;
 }
 
 void GeminiClient::run()
 {
     while (!threadShouldExit())
     {
-        // Wait for a request
-        requestReady.wait(100);
+        // Sleep until a request arrives (or we're asked to stop)
+        requestReady.wait(-1);
         
         Request request;
         bool shouldProcess = false;
@@ -67,7 +362,7 @@ void GeminiClient::run()
             const juce::ScopedLock lock(requestLock);
             if (hasRequest)
             {
-                request = currentRequest;
+                request = pendingRequest;
                 hasRequest = false;
                 shouldProcess = true;
             }
@@ -75,8 +370,16 @@ void GeminiClient::run()
         
         if (shouldProcess && request.callback)
         {
-            juce::String processedText;
-            bool success = makeGeminiRequest(request.input, processedText);
+            juce::String processedText, error;
+            bool success = makeGeminiRequest(request.input, processedText, error, request.generation);
+            
+            // A finished response is still worth caching even if newer text
+            // has arrived since, but only the latest text gets applied
+            if (success)
+                responseCache.store(request.input, processedText);
+            
+            if (!isLatestGeneration(request.generation))
+                continue;
             
             if (success)
             {
@@ -85,31 +388,47 @@ void GeminiClient::run()
             else
             {
                 // On error, return original input as fallback
-                request.callback(false, request.input, lastError);
+                lastError = error;
+                request.callback(false, request.input, error);
             }
         }
     }
 }
 
-bool GeminiClient::makeGeminiRequest(const juce::String& input, juce::String& output)
+bool GeminiClient::makeGeminiRequest(const juce::String& input, juce::String& output, juce::String& error,
+                                     juce::int64 generation, RequestTiming* timing)
 {
-    lastError.clear();
+    if (!sendPrompt(buildPrompt(input), 500, output, error, generation, timing))
+        return false;
+    
+    // Check if Gemini returned [INVALID]
+    if (output.contains("[INVALID]"))
+    {
+        error = "Request doesn't relate to audio processing";
+        return false;
+    }
+    
+    return true;
+}
+
+bool GeminiClient::sendPrompt(const juce::String& prompt, int maxOutputTokens, juce::String& output, juce::String& error,
+                              juce::int64 generation, RequestTiming* timing)
+{
+    error.clear();
+    
+    const juce::String requestEndpoint = getEndpoint();
     
-    // Verify API key is set
-    if (apiKey.isEmpty() || !apiKey.startsWith("AIza"))
+    // Verify API key is set (stand-in servers accept any key)
+    if (apiKey.isEmpty() || (requestEndpoint == getDefaultEndpoint() && !apiKey.startsWith("AIza")))
     {
-        lastError = "Invalid API key format";
+        error = "Invalid API key format";
         return false;
     }
     
     // Build the API URL (without POST data in URL)
-    // Using Gemini 1.5 Flash (free tier) for faster responses
-    juce::String urlString = "https://generativelanguage.googleapis.com/v1beta/models/gemini-1.5-flash:generateContent?key=" + apiKey;
+    juce::String urlString = requestEndpoint + "?key=" + apiKey;
     juce::URL url(urlString);
     
-    // Build the request payload
-    juce::String prompt = buildPrompt(input);
-    
     // Escape JSON string properly
     juce::String escapedPrompt = prompt.replace("\\", "\\\\")
                                        .replace("\"", "\\\"")
@@ -125,7 +444,7 @@ bool GeminiClient::makeGeminiRequest(const juce::String& input, juce::String& ou
         "  }],\n"
         "  \"generationConfig\": {\n"
         "    \"temperature\": 0.3,\n"
-        "    \"maxOutputTokens\": 500\n"
+        "    \"maxOutputTokens\": " + juce::String(maxOutputTokens) + "\n"
         "  }\n"
         "}";
     
@@ -136,53 +455,99 @@ bool GeminiClient::makeGeminiRequest(const juce::String& input, juce::String& ou
     // Set POST data on URL
     url = url.withPOSTData(postDataBlock);
     
-    // Create input stream which will automatically use POST when POST data is set
-    auto inputStream = url.createInputStream(juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inPostData)
-        .withExtraHeaders("Content-Type: application/json\r\n")
-        .withConnectionTimeoutMs(10000)
-        .withNumRedirectsToFollow(3));
+    // Another thread can cancel() the stream. It takes an open connection
+    // from the client's cache when there is one (with libcurl), and leaves
+    // its own there for the next request
+    GeminiHttpStream stream(connections, url, "Content-Type: application/json\r\n", 10000);
     
-    if (inputStream == nullptr)
+    // Requests from the worker can be aborted by newer text; generation 0
+    // (processTextSync and queued requests) always runs to completion
     {
-        lastError = "Failed to connect to Gemini API. Check your internet connection and API key.";
+        const juce::ScopedLock lock(requestLock);
+        if (generation != 0)
+        {
+            if (generation != latestGeneration)
+            {
+                error = "Superseded by newer text";
+                return false;
+            }
+            activeStream = &stream;
+        }
+        openStreams.add(&stream);
+    }
+    
+    // Parse the response as it arrives, keeping only the text and any
+    // error object, and stop once the JSON is complete
+    GeminiResponseParser parser;
+    juce::int64 bytesRead = 0;
+    
+    const bool connected = stream.perform([&parser, &bytesRead](const char* data, size_t size)
+    {
+        parser.feed(data, size);
+        bytesRead += (juce::int64)size;
+        return !parser.isComplete() && !parser.isMalformed();
+    });
+    
+    const int statusCode = connected ? stream.getStatusCode() : 0;
+    
+    if (timing != nullptr)
+    {
+        timing->connectMs = stream.getConnectMs();
+        timing->transferMs = stream.getTransferMs();
+        timing->statusCode = statusCode;
+        timing->reusedConnection = stream.isConnectionReused();
+    }
+    
+    {
+        const juce::ScopedLock lock(requestLock);
+        if (generation != 0)
+            activeStream = nullptr;
+        openStreams.removeFirstMatchingValue(&stream);
+    }
+    
+    if (!connected)
+    {
+        error = "Failed to connect to Gemini API. Check your internet connection and API key.";
+        return false;
+    }
+    
+    if (parser.hasError())
+    {
+        error = "API Error: " + juce::String(parser.getErrorCode()) + " " + parser.getErrorStatus() + ": " + parser.getErrorMessage();
         return false;
     }
     
-    // Read response
-    juce::String responseText = inputStream->readEntireStreamAsString();
+    if (bytesRead == 0)
+    {
+        error = "Empty response from Gemini API";
+        return false;
+    }
     
-    // Check if response contains error
-    if (responseText.contains("error") || responseText.contains("Error"))
+    if (statusCode >= 400)
     {
-        // Try to parse error message
-        lastError = "API Error: " + responseText.substring(0, 200); // Limit error message length
+        error = "API Error: HTTP " + juce::String(statusCode) + ": " + parser.getResponseStart();
         return false;
     }
     
-    if (responseText.isEmpty())
+    if (!parser.isComplete())
     {
-        lastError = "Empty response from Gemini API";
+        error = parser.isMalformed() ? "Invalid JSON response format" : "Response ended early";
         return false;
     }
     
-    // Parse the JSON response
-    return parseGeminiResponse(responseText, output);
+    if (!parser.hasText())
+    {
+        error = "No text in response";
+        return false;
+    }
+    
+    output = parser.getText().trim();
+    return true;
 }
 
 juce::String GeminiClient::buildPrompt(const juce::String& userInput)
 {
-    return juce::String("You are an audio engineering assistant. Your task is to convert the user's natural language request into standardized audio engineering keywords that describe what they want.\n\n")
-        + "Available keyword categories:\n"
-        + "- Brightness: bright, airy, sparkle, clarity, crisp, presence, shine, clear, detailed, highs, treble\n"
-        + "- Warmth: warm, smooth, body, full, thick, round, mellow, soft, sweet\n"
-        + "- Reverb: reverb, room, space, spacious, hall, ambience, ambient, echo, wet, atmosphere, add reverb\n"
-        + "- Compression: punch, punchy, tight, glue, cohesion, consistent, control, level, even\n"
-        + "- Bass: bass, low end, lows, deep, boom, thump, kick, weight, heavy, add bass\n"
-        + "- Presence: presence, forward, upfront, cut, vocal, mids, midrange, snap\n\n"
-        + "IMPORTANT - Handle removal commands:\n"
-        + "- If user says 'remove X', 'no X', 'without X', 'take away X', convert to: 'remove [keyword]'\n"
-        + "- If user says 'add X', 'more X', 'with X', convert to the positive keyword\n"
-        + "- If user says 'less X', 'reduce X', 'lower X', convert to negative version\n\n"
+    return getKeywordGuide()
         + "User's request: \"" + userInput + "\"\n\n"
         + "Instructions:\n"
         + "1. Extract the audio engineering intent from the user's request\n"
@@ -194,76 +559,58 @@ juce::String GeminiClient::buildPrompt(const juce::String& userInput)
         + "Processed keywords:";
 }
 
-bool GeminiClient::parseGeminiResponse(const juce::String& jsonResponse, juce::String& processedText)
+juce::String GeminiClient::buildBatchPrompt(const juce::StringArray& userInputs)
 {
-    try
-    {
-        // Parse JSON using JUCE's JSON parser
-        auto json = juce::JSON::parse(jsonResponse);
-        
-        if (!json.isObject())
-        {
-            lastError = "Invalid JSON response format";
-            return false;
-        }
-        
-        auto candidates = json.getProperty("candidates", juce::var());
-        if (!candidates.isArray() || candidates.getArray()->size() == 0)
-        {
-            lastError = "No candidates in response";
-            return false;
-        }
-        
-        auto firstCandidate = candidates.getArray()->getFirst();
-        if (!firstCandidate.isObject())
-        {
-            lastError = "Invalid candidate format";
-            return false;
-        }
-        
-        auto content = firstCandidate.getProperty("content", juce::var());
-        if (!content.isObject())
-        {
-            lastError = "Invalid content format";
-            return false;
-        }
-        
-        auto parts = content.getProperty("parts", juce::var());
-        if (!parts.isArray() || parts.getArray()->size() == 0)
-        {
-            lastError = "No parts in content";
-            return false;
-        }
-        
-        auto firstPart = parts.getArray()->getFirst();
-        if (!firstPart.isObject())
-        {
-            lastError = "Invalid part format";
-            return false;
-        }
-        
-        auto text = firstPart.getProperty("text", juce::var());
-        if (!text.isString())
-        {
-            lastError = "No text in response";
-            return false;
-        }
-        
-        processedText = text.toString().trim();
-        
-        // Check if Gemini returned [INVALID]
-        if (processedText.contains("[INVALID]"))
-        {
-            lastError = "Request doesn't relate to audio processing";
-            return false;
-        }
-        
-        return true;
-    }
-    catch (...)
-    {
-        lastError = "Failed to parse JSON response";
+    // As JSON, so quotes and newlines in one request can't bleed into the next
+    juce::Array<juce::var> requests;
+    for (const auto& input : userInputs)
+        requests.add(input);
+    
+    return getKeywordGuide()
+        + "User's requests, as a JSON array: " + juce::JSON::toString(juce::var(requests), true) + "\n\n"
+        + "Instructions:\n"
+        + "1. Handle each request on its own, exactly as if it were the only one\n"
+        + "2. Extract its audio engineering intent and convert it to keywords from the categories above\n"
+        + "3. Preserve removal/intensity modifiers (remove, add, more, less, very, etc.)\n"
+        + "4. Keep each answer concise - maximum 50 words\n"
+        + "5. If a request doesn't relate to audio, answer it with \"[INVALID]\"\n"
+        + "6. Return ONLY a JSON array of " + juce::String(userInputs.size())
+        + " strings, the answers in the same order as the requests, nothing else\n\n"
+        + "JSON array:";
+}
+
+bool GeminiClient::splitBatchResponse(const juce::String& responseText, int expectedCount, juce::StringArray& answers)
+{
+    // Models sometimes wrap the array in a ```json fence; look past it
+    const int start = responseText.indexOfChar('[');
+    const int end = responseText.lastIndexOfChar(']');
+    if (start < 0 || end < start)
         return false;
-    }
+    
+    auto json = juce::JSON::parse(responseText.substring(start, end + 1));
+    if (!json.isArray() || json.size() != expectedCount)
+        return false;
+    
+    answers.clearQuick();
+    for (const auto& answer : *json.getArray())
+        answers.add(answer.toString().trim());
+    
+    return true;
+}
+
+juce::String GeminiClient::getKeywordGuide()
+{
+    return juce::String("You are an audio engineering assistant. Your task is to convert the user's natural language request into standardized audio engineering keywords that describe what they want.\n\n")
+        + "Available keyword categories:\n"
+        + "- Brightness: bright, airy, sparkle, clarity, crisp, presence, shine, clear, detailed, highs, treble\n"
+        + "- Warmth: warm, smooth, body, full, thick, round, mellow, soft, sweet\n"
+        + "- Reverb: reverb, room, space, spacious, hall, ambience, ambient, echo, wet, atmosphere, add reverb\n"
+        + "- Compression: punch, punchy, tight, glue, cohesion, consistent, control, level, even\n"
+        + "- Bass: bass, low end, lows, deep, boom, thump, kick, weight, heavy, add bass\n"
+        + "- Presence: presence, forward, upfront, cut, vocal, mids, midrange, snap\n\n"
+        + "IMPORTANT - Handle removal commands:\n"
+        + "- If user says 'remove X', 'no X', 'without X', 'take away X', convert to: 'remove [keyword]'\n"
+        + "- If user says 'add X', 'more X', 'with X', convert to the positive keyword\n"
+        + "- If user says 'less X', 'reduce X', 'lower X', convert to negative version\n\n";
 }
 
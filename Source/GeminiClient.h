@@ -1,7 +1,10 @@
 #pragma once
 
 #include <juce_core/juce_core.h>
+#include "GeminiHttpStream.h"
+#include "GeminiResponseCache.h"
 #include <functional>
+#include <vector>
 
 /**
  * Client for Google Gemini API integration.
@@ -16,6 +19,26 @@ public:
      */
     using ResponseCallback = std::function<void(bool, const juce::String&, const juce::String&)>;
     
+    /**
+     * Where the time went for one queued request, in milliseconds.
+     */
+    struct RequestTiming
+    {
+        double queuedMs = 0.0;      // waiting for a free request slot
+        double connectMs = 0.0;     // sending the request until response headers arrive
+        double transferMs = 0.0;    // reading the response body
+        double totalMs = 0.0;       // from queueing to the callback
+        int statusCode = 0;         // HTTP status, 0 if there was no response
+        bool fromCache = false;     // answered by the response cache, no network
+        bool reusedConnection = false;  // sent on a connection kept open from an earlier request
+    };
+    
+    /**
+     * Callback for queued requests.
+     * Parameters: (success, processedText, errorMessage, timing)
+     */
+    using TimedResponseCallback = std::function<void(bool, const juce::String&, const juce::String&, const RequestTiming&)>;
+    
     GeminiClient();
     ~GeminiClient() override;
     
@@ -25,6 +48,16 @@ public:
      */
     void setApiKey(const juce::String& apiKey);
     
+    /**
+     * The generateContent URL requests are posted to, without the key
+     * parameter. Defaults to Google's Gemini 1.5 Flash endpoint; point it at
+     * a local stand-in (Tools/MockGemini) for testing. API keys are only
+     * format-checked against the default endpoint.
+     */
+    void setEndpoint(const juce::String& generateContentUrl);
+    juce::String getEndpoint() const;
+    static juce::String getDefaultEndpoint();
+    
     /**
      * Check if API key is configured.
      */
@@ -40,6 +73,12 @@ public:
      */
     void processTextAsync(const juce::String& userInput, ResponseCallback callback);
     
+    /**
+     * Drop the text waiting for processTextAsync and abort the request in
+     * flight; neither calls back.
+     */
+    void cancelPendingRequests();
+    
     /**
      * Synchronous version - blocks until response is received.
      * Use with caution as it will block the calling thread.
@@ -50,6 +89,48 @@ public:
      */
     bool processTextSync(const juce::String& userInput, juce::String& processedText);
     
+    /**
+     * Process many inputs in as few requests as possible: up to
+     * maxPromptsPerRequest uncached inputs share one request, and Gemini
+     * answers them as a JSON array. Blocks until every input is done.
+     * 
+     * @param inputs The original user text inputs
+     * @param processedTexts Output, one per input; inputs that failed keep their original text
+     * @param succeeded Output, whether each input was processed
+     * @return true if every input was processed
+     */
+    bool processTextsSync(const juce::StringArray& inputs, juce::StringArray& processedTexts,
+                          juce::Array<bool>& succeeded, int maxPromptsPerRequest = 50);
+    
+    /**
+     * Queue text for processing alongside other queued text, for batch jobs.
+     * Unlike processTextAsync nothing is superseded: every call gets its
+     * callback, from one of up to getMaxConcurrentRequests() pool threads,
+     * so callbacks may arrive out of order.
+     */
+    void enqueueTextAsync(const juce::String& userInput, TimedResponseCallback callback);
+    
+    /**
+     * How many queued requests may be in flight at once (default 4).
+     * Changing it doesn't wait: requests queued before the change finish on
+     * the old pool alongside the new one, so until they have, more than
+     * numRequests can be in flight.
+     */
+    void setMaxConcurrentRequests(int numRequests);
+    int getMaxConcurrentRequests() const;
+    
+    /**
+     * Keep processed prompts on disk as well as in memory, so they survive
+     * between sessions; see GeminiResponseCache::setPersistentFile. Off by
+     * default. Pass an empty file to keep them in memory only.
+     */
+    void setPersistentCacheFile(const juce::File& file);
+    
+    /**
+     * Forget every cached response, in memory and on disk.
+     */
+    void clearCache() { responseCache.clear(); }
+    
     /**
      * Get the last error message, if any.
      */
@@ -63,19 +144,67 @@ private:
     {
         juce::String input;
         ResponseCallback callback;
+        juce::int64 generation = 0;
     };
     
     juce::String apiKey;
     juce::String lastError;
     juce::WaitableEvent requestReady;
+    
+    // Keep-alive connections shared by every request, from any thread
+    GeminiConnectionCache connections;
+    
+    // Everything below up to responseCache is guarded by requestLock.
+    // Each new piece of text starts a new generation; work for any older
+    // generation is dropped or aborted.
     juce::CriticalSection requestLock;
-    Request currentRequest;
+    juce::String endpoint;
+    Request pendingRequest;
     bool hasRequest = false;
+    juce::int64 latestGeneration = 0;
+    GeminiHttpStream* activeStream = nullptr;
+    
+    // Every stream currently open, from any thread, so shutdown can abort them
+    juce::Array<GeminiHttpStream*> openStreams;
+    
+    // Threads serving enqueueTextAsync, created on first use, and earlier
+    // pools still finishing their queue after a setMaxConcurrentRequests
+    std::unique_ptr<juce::ThreadPool> requestPool;
+    std::vector<std::unique_ptr<juce::ThreadPool>> retiredPools;
+    int maxConcurrentRequests = 4;
+    
+    // Successful responses by normalised prompt; hits never touch the network
+    GeminiResponseCache responseCache;
+    juce::File persistentCacheFile;
+    
+    /**
+     * Identifies the model and prompt template, so cached responses from a
+     * different version of either are not reused.
+     */
+    juce::String getCacheFingerprint();
     
     /**
-     * Make HTTP request to Gemini API.
+     * Supersede all earlier requests: drops the pending one and cancels the
+     * one in flight. Call with requestLock held.
+     * @return the new generation
      */
-    bool makeGeminiRequest(const juce::String& input, juce::String& output);
+    juce::int64 startNewGeneration();
+    
+    bool isLatestGeneration(juce::int64 generation);
+    
+    /**
+     * Make HTTP request to Gemini API. Requests with a non-zero generation
+     * are aborted as soon as a newer generation starts. Fills error rather
+     * than lastError, so requests can run on several threads at once.
+     */
+    bool makeGeminiRequest(const juce::String& input, juce::String& output, juce::String& error,
+                           juce::int64 generation = 0, RequestTiming* timing = nullptr);
+    
+    /**
+     * Send a complete prompt and return the model's text, whatever it says.
+     */
+    bool sendPrompt(const juce::String& prompt, int maxOutputTokens, juce::String& output, juce::String& error,
+                    juce::int64 generation = 0, RequestTiming* timing = nullptr);
     
     /**
      * Build the prompt for Gemini to process audio engineering requests.
@@ -83,8 +212,20 @@ private:
     juce::String buildPrompt(const juce::String& userInput);
     
     /**
-     * Parse JSON response from Gemini API.
+     * Build one prompt asking for several requests to be answered as a JSON
+     * array of keyword strings, in order.
+     */
+    juce::String buildBatchPrompt(const juce::StringArray& userInputs);
+    
+    /**
+     * Split the model's answer to buildBatchPrompt into one string per request.
+     * @return false unless it is an array of exactly expectedCount strings
+     */
+    static bool splitBatchResponse(const juce::String& responseText, int expectedCount, juce::StringArray& answers);
+    
+    /**
+     * Role, keyword categories and modifier rules shared by every prompt.
      */
-    bool parseGeminiResponse(const juce::String& jsonResponse, juce::String& processedText);
+    static juce::String getKeywordGuide();
 };
 
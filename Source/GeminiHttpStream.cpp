@@ -0,0 +1,208 @@
+#include "GeminiHttpStream.h"
+
+#if SONARA_GEMINI_USE_CURL
+ #include <curl/curl.h>
+#endif
+
+namespace
+{
+   #if SONARA_GEMINI_USE_CURL
+    void lockShare(CURL*, curl_lock_data data, curl_lock_access, void* cache)
+    {
+        static_cast<juce::CriticalSection*>(cache)[(size_t)data].enter();
+    }
+    
+    void unlockShare(CURL*, curl_lock_data data, void* cache)
+    {
+        static_cast<juce::CriticalSection*>(cache)[(size_t)data].exit();
+    }
+    
+    // libcurl calls this about once a second while waiting, and more often
+    // while data moves; returning non-zero aborts the transfer
+    int checkCancelled(void* cancelled, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+    {
+        return static_cast<std::atomic<bool>*>(cancelled)->load() ? 1 : 0;
+    }
+   #else
+    double millisecondsBetween(juce::int64 startTicks, juce::int64 endTicks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(endTicks - startTicks) * 1000.0;
+    }
+   #endif
+}
+
+GeminiConnectionCache::GeminiConnectionCache()
+{
+   #if SONARA_GEMINI_USE_CURL
+    static_assert(CURL_LOCK_DATA_LAST <= 8, "GeminiConnectionCache needs a lock for every kind of shared data");
+    
+    // Once per process, before the first handle; it isn't undone, libcurl
+    // is in use until the process exits
+    static const bool initialised = curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK;
+    if (!initialised)
+        return;
+    
+    share = curl_share_init();
+    if (share == nullptr)
+        return;
+    
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, locks.data());
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+   #endif
+}
+
+GeminiConnectionCache::~GeminiConnectionCache()
+{
+   #if SONARA_GEMINI_USE_CURL
+    // Closes every idle connection; no stream may still be using it
+    if (share != nullptr)
+        curl_share_cleanup(share);
+   #endif
+}
+
+#if SONARA_GEMINI_USE_CURL
+
+GeminiHttpStream::GeminiHttpStream(GeminiConnectionCache& connectionCache, const juce::URL& url,
+                                   const juce::String& extraHeaders, int connectionTimeoutMs)
+    : connections(connectionCache),
+      urlString(url.toString(true)),
+      postData(url.getPostDataAsMemoryBlock()),
+      headers(juce::StringArray::fromLines(extraHeaders)),
+      timeoutMs(connectionTimeoutMs)
+{
+    headers.removeEmptyStrings();
+}
+
+GeminiHttpStream::~GeminiHttpStream() = default;
+
+bool GeminiHttpStream::perform(const DataCallback& onData)
+{
+    CURL* handle = curl_easy_init();
+    if (handle == nullptr || cancelled)
+    {
+        if (handle != nullptr)
+            curl_easy_cleanup(handle);
+        return false;
+    }
+    
+    curl_slist* headerList = nullptr;
+    for (const auto& header : headers)
+        headerList = curl_slist_append(headerList, header.toRawUTF8());
+    
+    // The share handle is what keeps connections alive from one stream to
+    // the next; without it they would close with this handle
+    if (connections.share != nullptr)
+        curl_easy_setopt(handle, CURLOPT_SHARE, connections.share);
+    
+    curl_easy_setopt(handle, CURLOPT_URL, urlString.toRawUTF8());
+    curl_easy_setopt(handle, CURLOPT_POST, 1L);
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDS, postData.getData());
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)postData.getSize());
+    curl_easy_setopt(handle, CURLOPT_HTTPHEADER, headerList);
+    curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(handle, CURLOPT_MAXREDIRS, 3L);
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    
+    // Like juce::WebInputStream's timeout: for connecting, and for a
+    // connection that stops delivering data
+    curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT_MS, (long)timeoutMs);
+    curl_easy_setopt(handle, CURLOPT_LOW_SPEED_LIMIT, 1L);
+    curl_easy_setopt(handle, CURLOPT_LOW_SPEED_TIME, (long)juce::jmax(1, (timeoutMs + 999) / 1000));
+    
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeData);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, this);
+    curl_easy_setopt(handle, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(handle, CURLOPT_XFERINFOFUNCTION, checkCancelled);
+    curl_easy_setopt(handle, CURLOPT_XFERINFODATA, &cancelled);
+    
+    dataCallback = &onData;
+    wantsMoreData = true;
+    curl_easy_perform(handle);
+    dataCallback = nullptr;
+    
+    long responseCode = 0, numConnects = 0;
+    curl_off_t headersMicroseconds = 0, totalMicroseconds = 0;
+    curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &responseCode);
+    curl_easy_getinfo(handle, CURLINFO_NUM_CONNECTS, &numConnects);
+    curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &headersMicroseconds);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &totalMicroseconds);
+    
+    statusCode = (int)responseCode;
+    connectionReused = statusCode > 0 && numConnects == 0;
+    connectMs = (double)headersMicroseconds * 0.001;
+    transferMs = (double)juce::jmax((curl_off_t)0, totalMicroseconds - headersMicroseconds) * 0.001;
+    
+    // Hands the connection back to the share handle, open
+    curl_easy_cleanup(handle);
+    curl_slist_free_all(headerList);
+    
+    return statusCode > 0;
+}
+
+void GeminiHttpStream::cancel()
+{
+    cancelled = true;
+}
+
+size_t GeminiHttpStream::writeData(char* data, size_t size, size_t count, void* userData)
+{
+    auto* stream = static_cast<GeminiHttpStream*>(userData);
+    const size_t numBytes = size * count;
+    
+    // Whatever follows what the caller needed is still read, not refused:
+    // refusing it would make libcurl close the connection
+    if (stream->wantsMoreData && stream->dataCallback != nullptr)
+        stream->wantsMoreData = (*stream->dataCallback)(data, numBytes);
+    
+    return numBytes;
+}
+
+#else
+
+GeminiHttpStream::GeminiHttpStream(GeminiConnectionCache&, const juce::URL& url,
+                                   const juce::String& extraHeaders, int connectionTimeoutMs)
+    : stream(url, true)
+{
+    // POST, because the URL carries POST data
+    stream.withExtraHeaders(extraHeaders)
+          .withConnectionTimeout(connectionTimeoutMs)
+          .withNumRedirectsToFollow(3);
+}
+
+GeminiHttpStream::~GeminiHttpStream() = default;
+
+bool GeminiHttpStream::perform(const DataCallback& onData)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const bool connected = stream.connect(nullptr);
+    const auto connectedTicks = juce::Time::getHighResolutionTicks();
+    connectMs = millisecondsBetween(startTicks, connectedTicks);
+    
+    if (!connected)
+        return false;
+    
+    statusCode = stream.getStatusCode();
+    
+    char buffer[4096];
+    while (!stream.isExhausted())
+    {
+        const int numRead = stream.read(buffer, (int)sizeof(buffer));
+        if (numRead <= 0 || !onData(buffer, (size_t)numRead))
+            break;
+    }
+    
+    transferMs = millisecondsBetween(connectedTicks, juce::Time::getHighResolutionTicks());
+    return true;
+}
+
+void GeminiHttpStream::cancel()
+{
+    stream.cancel();
+}
+
+#endif
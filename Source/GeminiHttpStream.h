@@ -0,0 +1,107 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <functional>
+
+// Set by CMake on Linux builds where libcurl is installed
+#ifndef SONARA_GEMINI_USE_CURL
+ #define SONARA_GEMINI_USE_CURL 0
+#endif
+
+#if SONARA_GEMINI_USE_CURL
+struct Curl_share;
+#endif
+
+/**
+ * Connections kept open between requests, shared by every GeminiHttpStream
+ * created with it; one per GeminiClient.
+ *
+ * With libcurl, a request takes an idle keep-alive connection to the same
+ * host from here when there is one, skipping the TCP and TLS handshakes,
+ * and hands it back when done. Without it each stream is a
+ * juce::WebInputStream, and reuse is up to the platform's HTTP stack.
+ */
+class GeminiConnectionCache
+{
+public:
+    GeminiConnectionCache();
+    ~GeminiConnectionCache();
+
+private:
+    friend class GeminiHttpStream;
+    
+   #if SONARA_GEMINI_USE_CURL
+    Curl_share* share = nullptr;
+    
+    // One per kind of data libcurl shares (connections, DNS, TLS sessions)
+    std::array<juce::CriticalSection, 8> locks;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE(GeminiConnectionCache)
+};
+
+/**
+ * One POST request, whose response body is handed over as it arrives.
+ * Any thread can cancel() it while another is inside perform().
+ */
+class GeminiHttpStream
+{
+public:
+    /**
+     * Receives the response body piece by piece.
+     * Return false once the rest isn't needed.
+     */
+    using DataCallback = std::function<bool(const char* data, size_t size)>;
+    
+    /**
+     * @param url The URL to post to, with its POST data set
+     * @param extraHeaders Request headers, each ending in "\r\n"
+     * @param connectionTimeoutMs How long to wait for a connection, and for data once connected
+     */
+    GeminiHttpStream(GeminiConnectionCache& connections, const juce::URL& url,
+                     const juce::String& extraHeaders, int connectionTimeoutMs);
+    ~GeminiHttpStream();
+    
+    /**
+     * Send the request and read the response, blocking until the body ends,
+     * onData returns false or the stream is cancelled.
+     * @return false if no response arrived
+     */
+    bool perform(const DataCallback& onData);
+    
+    /**
+     * Abort perform() as soon as possible.
+     */
+    void cancel();
+    
+    int getStatusCode() const { return statusCode; }
+    double getConnectMs() const { return connectMs; }       // until the response headers arrived
+    double getTransferMs() const { return transferMs; }     // reading the body
+    bool isConnectionReused() const { return connectionReused; }
+
+private:
+    int statusCode = 0;
+    double connectMs = 0.0;
+    double transferMs = 0.0;
+    bool connectionReused = false;
+    
+   #if SONARA_GEMINI_USE_CURL
+    GeminiConnectionCache& connections;
+    juce::String urlString;
+    juce::MemoryBlock postData;
+    juce::StringArray headers;
+    int timeoutMs;
+    
+    std::atomic<bool> cancelled { false };
+    const DataCallback* dataCallback = nullptr;
+    bool wantsMoreData = true;
+    
+    static size_t writeData(char* data, size_t size, size_t count, void* stream);
+   #else
+    juce::WebInputStream stream;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE(GeminiHttpStream)
+};
@@ -0,0 +1,307 @@
+#include "GeminiResponseCache.h"
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    // juce::InterProcessLock::ScopedLockType waits forever; the cache would
+    // rather skip the disk than stall a request on another process
+    struct ScopedProcessLock
+    {
+        explicit ScopedProcessLock(juce::InterProcessLock& lockToEnter)
+            : processLock(lockToEnter), locked(lockToEnter.enter(2000))
+        {
+        }
+
+        ~ScopedProcessLock()
+        {
+            if (locked)
+                processLock.exit();
+        }
+
+        juce::InterProcessLock& processLock;
+        const bool locked;
+    };
+}
+
+GeminiResponseCache::GeminiResponseCache(size_t memoryCapacityToUse, size_t diskCapacityToUse)
+    : memoryCapacity(juce::jmax((size_t)1, memoryCapacityToUse)),
+      diskCapacity(juce::jmax((size_t)1, diskCapacityToUse))
+{
+}
+
+juce::String GeminiResponseCache::normalise(const juce::String& prompt)
+{
+    juce::String key;
+    key.preallocateBytes(prompt.getNumBytesAsUTF8());
+
+    bool pendingSpace = false;
+    for (auto c = prompt.getCharPointer(); !c.isEmpty(); ++c)
+    {
+        auto character = *c;
+        if (juce::CharacterFunctions::isWhitespace(character))
+        {
+            pendingSpace = key.isNotEmpty();
+            continue;
+        }
+
+        if (pendingSpace)
+        {
+            key += ' ';
+            pendingSpace = false;
+        }
+
+        key += juce::CharacterFunctions::toLowerCase(character);
+    }
+
+    return key;
+}
+
+bool GeminiResponseCache::lookup(const juce::String& prompt, juce::String& processedText)
+{
+    const auto key = normalise(prompt);
+    const juce::ScopedLock scopedLock(lock);
+
+    auto found = recentIndex.find(key);
+    if (found != recentIndex.end())
+    {
+        // Move to the front of the LRU list
+        recent.splice(recent.begin(), recent, found->second);
+        processedText = found->second->processedText;
+        return true;
+    }
+
+    auto onDisk = diskEntries.find(key);
+    if (onDisk != diskEntries.end())
+    {
+        processedText = onDisk->second.processedText;
+        remember(key, processedText);
+        return true;
+    }
+
+    return false;
+}
+
+void GeminiResponseCache::store(const juce::String& prompt, const juce::String& processedText)
+{
+    const auto key = normalise(prompt);
+    if (key.isEmpty())
+        return;
+
+    const juce::ScopedLock fileScopedLock(fileLock);
+
+    {
+        const juce::ScopedLock scopedLock(lock);
+        remember(key, processedText);
+
+        if (persistentFile == juce::File())
+            return;
+
+        auto& diskEntry = diskEntries[key];
+        const bool unchanged = diskEntry.processedText == processedText && diskEntry.sequence > 0;
+        diskEntry.processedText = processedText;
+        diskEntry.sequence = ++nextSequence;
+
+        if (unchanged)
+            return;
+    }
+
+    appendToPersistentFile(key, processedText);
+}
+
+void GeminiResponseCache::setPersistentFile(const juce::File& file, const juce::String& fingerprint)
+{
+    const juce::ScopedLock fileScopedLock(fileLock);
+
+    persistentFingerprint = fingerprint;
+    persistentFile = juce::File();
+    processLock.reset();
+    linesInFile = 0;
+
+    if (file != juce::File())
+    {
+        const auto fingerprintHash = juce::String::toHexString(fingerprint.hashCode64());
+        persistentFile = file.getSiblingFile(file.getFileNameWithoutExtension() + "-" + fingerprintHash
+                                             + file.getFileExtension());
+        processLock = std::make_unique<juce::InterProcessLock>("SonaraGeminiCache_"
+                                                               + juce::String::toHexString(persistentFile.getFullPathName().hashCode64()));
+    }
+
+    {
+        const juce::ScopedLock scopedLock(lock);
+        recent.clear();
+        recentIndex.clear();
+        diskEntries.clear();
+    }
+
+    if (processLock != nullptr)
+    {
+        const ScopedProcessLock scopedProcessLock(*processLock);
+        if (scopedProcessLock.locked)
+            loadPersistentFile();
+    }
+}
+
+void GeminiResponseCache::clear()
+{
+    const juce::ScopedLock fileScopedLock(fileLock);
+
+    {
+        const juce::ScopedLock scopedLock(lock);
+        recent.clear();
+        recentIndex.clear();
+        diskEntries.clear();
+    }
+
+    if (processLock != nullptr)
+    {
+        const ScopedProcessLock scopedProcessLock(*processLock);
+        if (scopedProcessLock.locked)
+            rewritePersistentFile();
+    }
+}
+
+void GeminiResponseCache::remember(const juce::String& key, const juce::String& processedText)
+{
+    auto found = recentIndex.find(key);
+    if (found != recentIndex.end())
+    {
+        found->second->processedText = processedText;
+        recent.splice(recent.begin(), recent, found->second);
+        return;
+    }
+
+    recent.push_front({ key, processedText });
+    recentIndex[key] = recent.begin();
+
+    if (recent.size() > memoryCapacity)
+    {
+        recentIndex.erase(recent.back().key);
+        recent.pop_back();
+    }
+}
+
+void GeminiResponseCache::loadPersistentFile()
+{
+    juce::StringArray lines;
+    persistentFile.readLines(lines);
+    lines.removeEmptyStrings();
+
+    // First line is the fingerprint the entries were written under; a
+    // missing or different one means a new file, or one that isn't ours
+    if (lines.isEmpty() || juce::JSON::parse(lines[0]).toString() != persistentFingerprint)
+    {
+        {
+            const juce::ScopedLock scopedLock(lock);
+            diskEntries.clear();
+        }
+
+        rewritePersistentFile();
+        return;
+    }
+
+    std::vector<std::pair<juce::String, juce::String>> loaded;
+    loaded.reserve((size_t)lines.size());
+    for (int i = 1; i < lines.size(); ++i)
+    {
+        auto line = juce::JSON::parse(lines[i]);
+        if (line.isArray() && line.size() == 2)
+            loaded.emplace_back(line[0].toString(), line[1].toString());
+    }
+
+    // The file holds everything every process stored, ours included, so it
+    // replaces the mirror. Later lines win, so a re-stored prompt keeps its
+    // newest response.
+    bool overCapacity = false;
+    {
+        const juce::ScopedLock scopedLock(lock);
+        diskEntries.clear();
+        for (const auto& entry : loaded)
+        {
+            auto& diskEntry = diskEntries[entry.first];
+            diskEntry.processedText = entry.second;
+            diskEntry.sequence = ++nextSequence;
+        }
+        overCapacity = diskEntries.size() > diskCapacity;
+    }
+
+    linesInFile = lines.size() - 1;
+
+    if ((size_t)linesInFile >= diskCapacity * 2 || overCapacity)
+        rewritePersistentFile();
+}
+
+void GeminiResponseCache::appendToPersistentFile(const juce::String& key, const juce::String& processedText)
+{
+    if (processLock == nullptr)
+        return;
+
+    const ScopedProcessLock scopedProcessLock(*processLock);
+    if (!scopedProcessLock.locked)
+        return;
+
+    // Deleted since it was loaded: start it again, header first
+    if (!persistentFile.existsAsFile())
+    {
+        rewritePersistentFile();
+        return;
+    }
+
+    {
+        juce::FileOutputStream stream(persistentFile);
+        if (!stream.openedOk())
+            return;
+
+        stream << toLine(key, processedText) << "\n";
+    }
+
+    // Re-stored prompts and entries past capacity pile up in the log, from
+    // every process using it. Once this one has added enough to maybe reach
+    // twice the capacity, reload, which compacts if the file really is that long.
+    if ((size_t)++linesInFile >= diskCapacity * 2)
+        loadPersistentFile();
+}
+
+void GeminiResponseCache::rewritePersistentFile()
+{
+    juce::String contents = juce::JSON::toString(persistentFingerprint) + "\n";
+    int numLines = 0;
+
+    {
+        const juce::ScopedLock scopedLock(lock);
+
+        // Keep the newest diskCapacity entries
+        std::vector<std::pair<juce::int64, juce::String>> bySequence;
+        bySequence.reserve(diskEntries.size());
+        for (const auto& entry : diskEntries)
+            bySequence.emplace_back(entry.second.sequence, entry.first);
+
+        std::sort(bySequence.begin(), bySequence.end());
+
+        const size_t firstKept = bySequence.size() > diskCapacity ? bySequence.size() - diskCapacity : 0;
+        for (size_t i = 0; i < firstKept; ++i)
+            diskEntries.erase(bySequence[i].second);
+
+        for (size_t i = firstKept; i < bySequence.size(); ++i)
+        {
+            const auto& key = bySequence[i].second;
+            contents << toLine(key, diskEntries[key].processedText) << "\n";
+        }
+
+        numLines = (int)(bySequence.size() - firstKept);
+    }
+
+    // Written to a temporary file and moved into place, so a reader never
+    // sees half of it
+    persistentFile.getParentDirectory().createDirectory();
+    persistentFile.replaceWithText(contents);
+    linesInFile = numLines;
+}
+
+juce::String GeminiResponseCache::toLine(const juce::String& key, const juce::String& processedText)
+{
+    juce::Array<juce::var> line;
+    line.add(key);
+    line.add(processedText);
+    return juce::JSON::toString(juce::var(line), true);
+}
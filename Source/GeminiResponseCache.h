@@ -0,0 +1,101 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+/**
+ * Remembers what Gemini made of each prompt, so asking again for text that
+ * has already been processed skips the network entirely.
+ *
+ * Prompts are normalised (case and whitespace) before lookup. Recent entries
+ * live in a small LRU list; with a persistent file set, every entry is also
+ * kept in a larger on-disk tier that survives between sessions.
+ *
+ * Several caches, in one process or many, can share a persistent file:
+ * every read and write of it holds an inter-process lock, and compaction
+ * reloads the file first so entries others appended are kept.
+ *
+ * All methods are thread safe. Lookups never wait for disk access.
+ */
+class GeminiResponseCache
+{
+public:
+    GeminiResponseCache(size_t memoryCapacity = 256, size_t diskCapacity = 4096);
+
+    /**
+     * Key used for a prompt: lower case, trimmed, runs of whitespace
+     * collapsed to one space.
+     */
+    static juce::String normalise(const juce::String& prompt);
+
+    /**
+     * Find a cached response for the prompt.
+     * @return true and fills processedText on a hit
+     */
+    bool lookup(const juce::String& prompt, juce::String& processedText);
+
+    /**
+     * Remember a successful response for the prompt.
+     */
+    void store(const juce::String& prompt, const juce::String& processedText);
+
+    /**
+     * Load and keep writing to a persistent tier next to this file. Each
+     * fingerprint (model and prompt template) gets its own file, named
+     * after the given one with the fingerprint appended, so caches
+     * configured differently never overwrite each other's entries. The
+     * in-memory tier starts over. Pass an empty file to turn the
+     * persistent tier off.
+     */
+    void setPersistentFile(const juce::File& file, const juce::String& fingerprint);
+
+    /**
+     * Forget everything, including the persistent tier's file.
+     */
+    void clear();
+
+private:
+    struct Entry
+    {
+        juce::String key;
+        juce::String processedText;
+    };
+
+    struct DiskEntry
+    {
+        juce::String processedText;
+        juce::int64 sequence = 0;
+    };
+
+    const size_t memoryCapacity;
+    const size_t diskCapacity;
+
+    // Taken before lock when both are needed; file access holds only this
+    // one, so lookups don't wait for the disk
+    juce::CriticalSection fileLock;
+    juce::CriticalSection lock;
+
+    // Most recently used first
+    std::list<Entry> recent;
+    std::unordered_map<juce::String, std::list<Entry>::iterator> recentIndex;
+
+    // Persistent tier: an append-only file of JSON lines, mirrored in
+    // diskEntries. The file, its fingerprint, process lock and line count
+    // are guarded by fileLock; diskEntries by lock.
+    juce::File persistentFile;
+    juce::String persistentFingerprint;
+    std::unique_ptr<juce::InterProcessLock> processLock;
+    int linesInFile = 0;
+    std::unordered_map<juce::String, DiskEntry> diskEntries;
+    juce::int64 nextSequence = 0;
+
+    void remember(const juce::String& key, const juce::String& processedText);
+
+    // These hold fileLock and processLock
+    void loadPersistentFile();
+    void appendToPersistentFile(const juce::String& key, const juce::String& processedText);
+    void rewritePersistentFile();
+    static juce::String toLine(const juce::String& key, const juce::String& processedText);
+};
@@ -0,0 +1,342 @@
+#include "GeminiResponseParser.h"
+
+namespace
+{
+    bool isWhitespace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    bool isScalarCharacter(char c)
+    {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E';
+    }
+
+    int hexValue(char c)
+    {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+}
+
+void GeminiResponseParser::feed(const void* data, size_t numBytes)
+{
+    auto* bytes = static_cast<const char*>(data);
+
+    if (responseStart.size() < maxResponseStart)
+        responseStart.append(bytes, juce::jmin(numBytes, maxResponseStart - responseStart.size()));
+
+    for (size_t i = 0; i < numBytes && state != State::done && state != State::malformed; ++i)
+        process(bytes[i]);
+}
+
+juce::String GeminiResponseParser::getText() const
+{
+    return juce::String::fromUTF8(text.data(), (int)text.size());
+}
+
+juce::String GeminiResponseParser::getErrorMessage() const
+{
+    return juce::String::fromUTF8(errorMessage.data(), (int)errorMessage.size());
+}
+
+juce::String GeminiResponseParser::getErrorStatus() const
+{
+    return juce::String::fromUTF8(errorStatus.data(), (int)errorStatus.size());
+}
+
+juce::String GeminiResponseParser::getResponseStart() const
+{
+    return juce::String::fromUTF8(responseStart.data(), (int)responseStart.size());
+}
+
+void GeminiResponseParser::process(char c)
+{
+    switch (state)
+    {
+        case State::string:
+            if (unicodeDigits >= 0)
+            {
+                const int digit = hexValue(c);
+                if (digit < 0)
+                {
+                    state = State::malformed;
+                    return;
+                }
+
+                unicodeValue = (unicodeValue << 4) | (juce::uint32)digit;
+                if (++unicodeDigits == 4)
+                {
+                    unicodeDigits = -1;
+                    appendCodePoint(unicodeValue);
+                }
+            }
+            else if (escaped)
+            {
+                escaped = false;
+                switch (c)
+                {
+                    case 'n': appendToTarget('\n'); break;
+                    case 't': appendToTarget('\t'); break;
+                    case 'r': appendToTarget('\r'); break;
+                    case 'b': appendToTarget('\b'); break;
+                    case 'f': appendToTarget('\f'); break;
+                    case 'u': unicodeDigits = 0; unicodeValue = 0; break;
+                    default:  appendToTarget(c); break;
+                }
+            }
+            else if (c == '\\')
+            {
+                escaped = true;
+            }
+            else if (c == '"')
+            {
+                finishString();
+            }
+            else
+            {
+                appendToTarget(c);
+            }
+            return;
+
+        case State::scalar:
+            if (isScalarCharacter(c))
+            {
+                if (scalarText.size() < maxKeyLength)
+                    scalarText += c;
+                return;
+            }
+
+            finishScalar();
+            if (state == State::malformed)
+                return;
+            break; // the delimiter still needs handling below
+
+        default:
+            break;
+    }
+
+    if (isWhitespace(c))
+        return;
+
+    switch (state)
+    {
+        case State::value:
+            if (c == ']' && containerJustOpened)
+            {
+                frames.pop_back();
+                endValue();
+            }
+            else
+            {
+                beginValue(c);
+            }
+            break;
+
+        case State::key:
+            if (c == '}' && containerJustOpened)
+            {
+                frames.pop_back();
+                endValue();
+            }
+            else if (c == '"')
+            {
+                key.clear();
+                target = Target::key;
+                state = State::string;
+            }
+            else
+            {
+                state = State::malformed;
+            }
+            break;
+
+        case State::colon:
+            state = c == ':' ? State::value : State::malformed;
+            containerJustOpened = false;
+            break;
+
+        case State::commaOrClose:
+        {
+            auto& frame = frames.back();
+            if (c == ',')
+            {
+                state = frame.isObject ? State::key : State::value;
+                containerJustOpened = false;
+            }
+            else if (c == (frame.isObject ? '}' : ']'))
+            {
+                frames.pop_back();
+                endValue();
+            }
+            else
+            {
+                state = State::malformed;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void GeminiResponseParser::beginValue(char c)
+{
+    containerJustOpened = false;
+
+    if (!frames.empty() && !frames.back().isObject)
+        ++frames.back().index;
+
+    if (c == '{' || c == '[')
+    {
+        Frame frame;
+        frame.isObject = c == '{';
+        frames.push_back(frame);
+
+        // The error object only counts at the top level of a response
+        if (frame.isObject && frames.size() >= 2)
+        {
+            const auto& parent = frames[frames.size() - 2];
+            const bool topLevel = frames.size() == 2 || (frames.size() == 3 && !frames[0].isObject);
+            if (topLevel && parent.isObject && parent.key == "error")
+                foundError = true;
+        }
+
+        state = frame.isObject ? State::key : State::value;
+        containerJustOpened = true;
+    }
+    else if (c == '"')
+    {
+        target = getTarget();
+        if (target == Target::text)
+            foundText = true;
+        state = State::string;
+    }
+    else if (isScalarCharacter(c))
+    {
+        target = getTarget();
+        scalarText.assign(1, c);
+        state = State::scalar;
+    }
+    else
+    {
+        state = State::malformed;
+    }
+}
+
+void GeminiResponseParser::endValue()
+{
+    target = Target::none;
+    containerJustOpened = false;
+    state = frames.empty() ? State::done : State::commaOrClose;
+}
+
+GeminiResponseParser::Target GeminiResponseParser::getTarget() const
+{
+    // A streamed response is an array of ordinary responses
+    const size_t base = (!frames.empty() && !frames[0].isObject) ? 1 : 0;
+    const size_t depth = frames.size() - base;
+
+    auto keyAt = [&](size_t level, const char* name)
+    {
+        return frames[base + level].isObject && frames[base + level].key == name;
+    };
+    auto indexAt = [&](size_t level)
+    {
+        return frames[base + level].isObject ? -1 : frames[base + level].index;
+    };
+
+    // candidates[0].content.parts[n].text
+    if (depth == 6 && keyAt(0, "candidates") && indexAt(1) == 0 && keyAt(2, "content")
+        && keyAt(3, "parts") && indexAt(4) >= 0 && keyAt(5, "text"))
+        return Target::text;
+
+    // error.message, error.status, error.code
+    if (depth == 2 && keyAt(0, "error") && frames[base + 1].isObject)
+    {
+        const auto& name = frames[base + 1].key;
+        if (name == "message") return Target::errorMessage;
+        if (name == "status")  return Target::errorStatus;
+        if (name == "code")    return Target::errorCode;
+    }
+
+    return Target::none;
+}
+
+std::string* GeminiResponseParser::getTargetString()
+{
+    switch (target)
+    {
+        case Target::key:          return &key;
+        case Target::text:         return &text;
+        case Target::errorMessage: return &errorMessage;
+        case Target::errorStatus:  return &errorStatus;
+        default:                   return nullptr;
+    }
+}
+
+void GeminiResponseParser::appendToTarget(char c)
+{
+    // Strings nobody wants are read past without being stored
+    if (auto* destination = getTargetString())
+        if (target != Target::key || destination->size() < maxKeyLength)
+            *destination += c;
+}
+
+void GeminiResponseParser::appendCodePoint(juce::uint32 codePoint)
+{
+    // \u escapes are UTF-16, so characters past the BMP arrive as a surrogate pair
+    if (codePoint >= 0xd800 && codePoint < 0xdc00)
+    {
+        highSurrogate = codePoint;
+        return;
+    }
+
+    if (codePoint >= 0xdc00 && codePoint < 0xe000)
+    {
+        if (highSurrogate == 0)
+            return;
+
+        codePoint = 0x10000 + ((highSurrogate - 0xd800) << 10) + (codePoint - 0xdc00);
+    }
+
+    highSurrogate = 0;
+
+    char utf8[4];
+    const auto numBytes = juce::CharPointer_UTF8::getBytesRequiredFor((juce::juce_wchar)codePoint);
+    juce::CharPointer_UTF8 writer(utf8);
+    writer.write((juce::juce_wchar)codePoint);
+
+    for (size_t i = 0; i < numBytes; ++i)
+        appendToTarget(utf8[i]);
+}
+
+void GeminiResponseParser::finishString()
+{
+    if (target == Target::key)
+    {
+        frames.back().key = key;
+        target = Target::none;
+        state = State::colon;
+        return;
+    }
+
+    endValue();
+}
+
+void GeminiResponseParser::finishScalar()
+{
+    if (target == Target::errorCode)
+        errorCode = juce::String(scalarText).getIntValue();
+
+    const bool isLiteral = scalarText == "true" || scalarText == "false" || scalarText == "null";
+    const bool isNumber = scalarText[0] == '-' || (scalarText[0] >= '0' && scalarText[0] <= '9');
+
+    if (isLiteral || isNumber)
+        endValue();
+    else
+        state = State::malformed;
+}
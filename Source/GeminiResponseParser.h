@@ -0,0 +1,100 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <string>
+#include <vector>
+
+/**
+ * Incremental parser for Gemini generateContent responses.
+ *
+ * Bytes are fed in as they arrive from the network, split anywhere. Only
+ * what Sonara uses is kept: the text of candidates[0].content.parts, and
+ * the error object the API returns on failure. Everything else is skipped
+ * without being stored, so the response never exists as one big string or
+ * var tree.
+ *
+ * A streamed response (a JSON array of partial responses, as
+ * streamGenerateContent returns) also works; the text of each partial
+ * response is appended in order.
+ */
+class GeminiResponseParser
+{
+public:
+    GeminiResponseParser() = default;
+
+    /**
+     * Parse the next piece of the response. Input after a complete JSON
+     * value, or after the response turned out not to be JSON, is ignored.
+     */
+    void feed(const void* data, size_t numBytes);
+
+    /** True once a whole top-level JSON value has been read. */
+    bool isComplete() const { return state == State::done; }
+
+    /** True if the bytes so far can't be a JSON document. */
+    bool isMalformed() const { return state == State::malformed; }
+
+    /** True if any candidates[0].content.parts[].text string was found. */
+    bool hasText() const { return foundText; }
+    juce::String getText() const;
+
+    /** True if the response had a top-level error object. */
+    bool hasError() const { return foundError; }
+    int getErrorCode() const { return errorCode; }
+    juce::String getErrorMessage() const;
+    juce::String getErrorStatus() const;
+
+    /** The first bytes of the response, for error reports. */
+    juce::String getResponseStart() const;
+
+private:
+    enum class State
+    {
+        value,          // expecting a value; ']' also allowed straight after '['
+        key,            // expecting a key; '}' also allowed straight after '{'
+        colon,
+        commaOrClose,
+        string,
+        scalar,         // number, true, false or null
+        done,
+        malformed
+    };
+
+    // What the value being read is, if it's one we keep
+    enum class Target { none, key, text, errorMessage, errorStatus, errorCode };
+
+    struct Frame
+    {
+        bool isObject = false;
+        std::string key;    // object: the key of the current member
+        int index = -1;     // array: the index of the current element
+    };
+
+    static constexpr size_t maxKeyLength = 32;
+    static constexpr size_t maxResponseStart = 200;
+
+    State state = State::value;
+    bool containerJustOpened = false;
+    std::vector<Frame> frames;
+
+    Target target = Target::none;
+    bool escaped = false;
+    int unicodeDigits = -1;         // -1 outside a \u escape, else digits read so far
+    juce::uint32 unicodeValue = 0;
+    juce::uint32 highSurrogate = 0;
+    std::string scalarText;
+
+    std::string text, errorMessage, errorStatus, key, responseStart;
+    bool foundText = false, foundError = false;
+    int errorCode = 0;
+
+    void process(char c);
+    void beginValue(char c);
+    void endValue();
+    Target getTarget() const;
+    void appendToTarget(char c);
+    void appendCodePoint(juce::uint32 codePoint);
+    void finishString();
+    void finishScalar();
+    std::string* getTargetString();
+};
@@ -1,70 +1,134 @@
 #include "KeywordMapper.h"
 #include "GeminiClient.h"
+#include "KeywordRules.h"
 
-KeywordMapper::KeywordMapper() {
-    // Gemini client will be created when API key is set
-    geminiClient = nullptr;
-    
-    // Initialize keyword lists
-    brightnessKeywords = {
-        "bright", "brighter", "brightness", "sparkle", "sparkly", "air", "airy", "airiness",
-        "crisp", "crispy", "highs", "high end", "treble", "presence", "shine", "shiny",
-        "clear", "clearer", "clarity", "detail", "detailed"
-    };
-    
-    warmthKeywords = {
-        "warm", "warmer", "warmth", "smooth", "smoother", "body", "full", "fuller",
-        "thick", "thicker", "round", "rounder", "mellow", "soft", "softer", "sweet"
-    };
+namespace {
+    using KeywordRules::Parameter;
     
-    reverbKeywords = {
-        "reverb", "verb", "room", "space", "spacious", "hall", "ambience", "ambient",
-        "distance", "distant", "echo", "echoes", "wet", "wetness", "atmosphere", "atmospheric"
-    };
-    
-    compressorKeywords = {
-        "punch", "punchy", "tight", "tighter", "glue", "glued", "glue the mix", "cohesion",
-        "consistent", "consistent dynamics", "control", "controlled", "compression", "compress",
-        "even", "even dynamics", "level", "leveled"
-    };
+    float getParameter(const AudioParameters& params, Parameter parameter) {
+        switch (parameter) {
+            case Parameter::highShelfFreq: return params.eq.highShelfFreq;
+            case Parameter::highShelfGain: return params.eq.highShelfGain;
+            case Parameter::midFreq: return params.eq.midFreq;
+            case Parameter::midGain: return params.eq.midGain;
+            case Parameter::midQ: return params.eq.midQ;
+            case Parameter::lowMidFreq: return params.eq.lowMidFreq;
+            case Parameter::lowMidGain: return params.eq.lowMidGain;
+            case Parameter::lowMidQ: return params.eq.lowMidQ;
+            case Parameter::lowShelfFreq: return params.eq.lowShelfFreq;
+            case Parameter::lowShelfGain: return params.eq.lowShelfGain;
+            case Parameter::compressorThreshold: return params.compressor.threshold;
+            case Parameter::compressorRatio: return params.compressor.ratio;
+            case Parameter::compressorAttack: return params.compressor.attack;
+            case Parameter::compressorRelease: return params.compressor.release;
+            case Parameter::compressorMakeupGain: return params.compressor.makeupGain;
+            case Parameter::compressorEnabled: return params.compressor.enabled ? 1.0f : 0.0f;
+            case Parameter::reverbRoomSize: return params.reverb.roomSize;
+            case Parameter::reverbDamping: return params.reverb.damping;
+            case Parameter::reverbWidth: return params.reverb.width;
+            case Parameter::reverbWetLevel: return params.reverb.wetLevel;
+            case Parameter::reverbDryLevel: return params.reverb.dryLevel;
+            case Parameter::reverbEnabled: return params.reverb.enabled ? 1.0f : 0.0f;
+            case Parameter::none: break;
+        }
+        return 0.0f;
+    }
     
-    bassKeywords = {
-        "bass", "low end", "lows", "low", "deeper", "deep", "boom", "boomy", "thump",
-        "thumpy", "kick", "punch", "weight", "heavy", "thick"
-    };
+    void setParameter(AudioParameters& params, Parameter parameter, float value) {
+        switch (parameter) {
+            case Parameter::highShelfFreq: params.eq.highShelfFreq = value; break;
+            case Parameter::highShelfGain: params.eq.highShelfGain = value; break;
+            case Parameter::midFreq: params.eq.midFreq = value; break;
+            case Parameter::midGain: params.eq.midGain = value; break;
+            case Parameter::midQ: params.eq.midQ = value; break;
+            case Parameter::lowMidFreq: params.eq.lowMidFreq = value; break;
+            case Parameter::lowMidGain: params.eq.lowMidGain = value; break;
+            case Parameter::lowMidQ: params.eq.lowMidQ = value; break;
+            case Parameter::lowShelfFreq: params.eq.lowShelfFreq = value; break;
+            case Parameter::lowShelfGain: params.eq.lowShelfGain = value; break;
+            case Parameter::compressorThreshold: params.compressor.threshold = value; break;
+            case Parameter::compressorRatio: params.compressor.ratio = value; break;
+            case Parameter::compressorAttack: params.compressor.attack = value; break;
+            case Parameter::compressorRelease: params.compressor.release = value; break;
+            case Parameter::compressorMakeupGain: params.compressor.makeupGain = value; break;
+            case Parameter::compressorEnabled: params.compressor.enabled = value != 0.0f; break;
+            case Parameter::reverbRoomSize: params.reverb.roomSize = value; break;
+            case Parameter::reverbDamping: params.reverb.damping = value; break;
+            case Parameter::reverbWidth: params.reverb.width = value; break;
+            case Parameter::reverbWetLevel: params.reverb.wetLevel = value; break;
+            case Parameter::reverbDryLevel: params.reverb.dryLevel = value; break;
+            case Parameter::reverbEnabled: params.reverb.enabled = value != 0.0f; break;
+            case Parameter::none: break;
+        }
+    }
     
-    presenceKeywords = {
-        "presence", "forward", "upfront", "cut", "cut through", "vocal", "vocals",
-        "mid", "mids", "midrange", "snap", "snappy"
-    };
+    bool conditionHolds(const KeywordRules::Condition& condition, const AudioParameters& params) {
+        if (condition.parameter == Parameter::none) return true;
+        
+        const float value = getParameter(params, condition.parameter);
+        return value >= condition.min && value <= condition.max;
+    }
+}
+
+KeywordMapper::KeywordMapper() {
+    // Gemini client will be created when API key is set; the keyword
+    // tables are constexpr data, so there is nothing else to build
+    geminiClient = nullptr;
 }
 
 AudioParameters KeywordMapper::processText(const juce::String& text, float baseIntensity) {
-    recentChanges.clear();
+    return applyIntensity(mapText(text), baseIntensity);
+}
+
+MappedText KeywordMapper::mapText(const juce::String& text) {
+    std::vector<ChangeLog> changes;
+    const MappedText mapped = mapKeywords(text, changes);
+    publish(mapped, std::move(changes), startRequest());
+    return mapped;
+}
+
+MappedText KeywordMapper::mapKeywords(const juce::String& text, std::vector<ChangeLog>& changes) {
+    // One case-insensitive pass finds every keyword and phrase in the text
+    const KeywordSet found = KeywordMatcher::getInstance().findAll(text);
     
-    // Convert to lowercase for matching
-    juce::String lowerText = text.toLowerCase();
+    MappedText mapped;
     
     // Extract intensity modifiers
-    float intensity = extractIntensity(lowerText) * baseIntensity;
+    mapped.keywordIntensity = extractIntensity(found);
     
-    // Initialize parameters
-    AudioParameters params;
-    params.intensity = intensity;
+    // Process each effect category, at nominal strength
+    applyRules(found, mapped.nominal, changes);
+    
+    return mapped;
+}
+
+juce::int64 KeywordMapper::startRequest() {
+    const juce::ScopedLock lock(resultLock);
+    return ++latestRequest;
+}
+
+bool KeywordMapper::publish(const MappedText& mapped, std::vector<ChangeLog> changes, juce::int64 request) {
+    const juce::ScopedLock lock(resultLock);
+    if (request != latestRequest)
+        return false;
     
-    // Process each effect category
-    processBrightnessKeywords(lowerText, params);
-    processWarmthKeywords(lowerText, params);
-    processReverbKeywords(lowerText, params);
-    processCompressorKeywords(lowerText, params);
-    processBassKeywords(lowerText, params);
-    processPresenceKeywords(lowerText, params);
+    recentChanges = std::move(changes);
+    lastMapped = mapped;
+    return true;
+}
+
+AudioParameters KeywordMapper::applyIntensity(const MappedText& mapped, float baseIntensity) {
+    const float intensity = mapped.keywordIntensity * baseIntensity;
+    
+    AudioParameters params = mapped.nominal;
+    params.intensity = intensity;
     
     // Apply intensity to all parameters (only if intensity is positive)
     // For negative values (like reductions), we still want them to work
     if (intensity > 0) {
         params.eq.highShelfGain *= intensity;
         params.eq.midGain *= intensity;
+        params.eq.lowMidGain *= intensity;
         params.eq.lowShelfGain *= intensity;
         params.reverb.wetLevel *= intensity;
         params.reverb.roomSize *= intensity;
@@ -77,279 +141,52 @@ AudioParameters KeywordMapper::processText(const juce::String& text, float baseI
     return params;
 }
 
-bool KeywordMapper::containsKeyword(const juce::String& text, const std::vector<juce::String>& keywords) {
-    for (const auto& keyword : keywords) {
-        if (text.contains(keyword)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-float KeywordMapper::extractIntensity(const juce::String& text) {
-    // Check for removal/reduction keywords first
-    if (text.contains("remove") || text.contains("no ") || text.contains("without") || 
-        text.contains("take away") || text.contains("eliminate") || text.contains("cut")) {
-        return -2.0f; // Strong negative for removal
-    }
-    if (text.contains("slight") || text.contains("little") || text.contains("bit")) return 0.5f;
-    if (text.contains("more") || text.contains("much") || text.contains("add")) return 1.5f;
-    if (text.contains("very") || text.contains("super") || text.contains("extreme")) return 2.0f;
-    if (text.contains("less") || text.contains("reduce") || text.contains("lower") || text.contains("decrease")) return -1.0f;
-    return 1.0f;
-}
-
-void KeywordMapper::processBrightnessKeywords(const juce::String& text, AudioParameters& params) {
-    // Check for removal first
-    if (text.contains("remove bright") || text.contains("no bright") || text.contains("without bright") ||
-        text.contains("remove highs") || text.contains("cut highs") || text.contains("take away bright")) {
-        params.eq.highShelfFreq = 8000.0f;
-        params.eq.highShelfGain = -5.0f;
-        addChange("High Shelf 8kHz -5.0dB (removed)", juce::Colour(0xff8affb4));
-    }
-    // Check for dark/dull (reduction)
-    else if (text.contains("dull") || text.contains("dark") || text.contains("muddy") ||
-             text.contains("less bright") || text.contains("reduce bright")) {
-        params.eq.highShelfFreq = 8000.0f;
-        params.eq.highShelfGain = -3.0f;
-        addChange("High Shelf 8kHz -3.0dB", juce::Colour(0xff8affb4));
-    }
-    // Then check for brightness boosts
-    else if (containsKeyword(text, brightnessKeywords)) {
-        if (text.contains("more air") || text.contains("airy") || text.contains("airiness")) {
-            params.eq.highShelfFreq = 10000.0f;
-            params.eq.highShelfGain = 4.0f;
-            addChange("High Shelf 10kHz +4.0dB", juce::Colour(0xff8affb4));
-        } 
-        else if (text.contains("sparkle") || text.contains("sparkly") || text.contains("shine") || text.contains("shiny")) {
-            params.eq.highShelfFreq = 12000.0f;
-            params.eq.highShelfGain = 3.0f;
-            addChange("High Shelf 12kHz +3.0dB", juce::Colour(0xff8affb4));
-        } 
-        else if (text.contains("crisp") || text.contains("crispy") || text.contains("highs") || text.contains("treble")) {
-            params.eq.highShelfFreq = 9000.0f;
-            params.eq.highShelfGain = 3.0f;
-            addChange("High Shelf 9kHz +3.0dB", juce::Colour(0xff8affb4));
-        }
-        else {
-            // Default brightness boost
-            params.eq.highShelfFreq = 8000.0f;
-            params.eq.highShelfGain = 2.5f;
-            addChange("High Shelf 8kHz +2.5dB", juce::Colour(0xff8affb4));
-        }
-        
-        // Clarity can be applied in addition to brightness
-        if (text.contains("clarity") || text.contains("clear") || text.contains("clearer") || 
-            text.contains("detail") || text.contains("detailed")) {
-            // Only apply clarity mid boost if presence hasn't already set a higher mid freq
-            if (params.eq.midFreq < 2000.0f || params.eq.midFreq == 2000.0f) {
-                params.eq.midFreq = 2500.0f;
-                params.eq.midGain = 2.0f;
-                params.eq.midQ = 1.5f;
-                addChange("Peak 2.5kHz +2.0dB Q:1.5", juce::Colour(0xff8affb4));
-            }
-        }
-    }
-}
-
-void KeywordMapper::processWarmthKeywords(const juce::String& text, AudioParameters& params) {
-    if (containsKeyword(text, warmthKeywords)) {
-        if (text.contains("warm") || text.contains("warmth")) {
-            params.eq.midFreq = 800.0f;
-            params.eq.midGain = 2.0f;
-            params.eq.midQ = 1.0f;
-            addChange("Peak 800Hz +2.0dB", juce::Colour(0xffa78bfa));
-            
-            params.eq.highShelfFreq = 10000.0f;
-            params.eq.highShelfGain = -1.5f;
-            addChange("High Shelf 10kHz -1.5dB", juce::Colour(0xffa78bfa));
-        }
-        
-        if (text.contains("body") || text.contains("full")) {
-            params.eq.midFreq = 300.0f;
-            params.eq.midGain = 3.0f;
-            params.eq.midQ = 1.5f;
-            addChange("Peak 300Hz +3.0dB", juce::Colour(0xffa78bfa));
-        }
-        
-        if (text.contains("smooth")) {
-            params.eq.highShelfFreq = 5000.0f;
-            params.eq.highShelfGain = -2.0f;
-            addChange("High Shelf 5kHz -2.0dB", juce::Colour(0xffa78bfa));
+float KeywordMapper::extractIntensity(const KeywordSet& found) {
+    // Removal/reduction words come first in the table, so they win
+    for (const auto& modifier : KeywordRules::modifiers) {
+        if (found.containsAny(modifier.anyOf)) {
+            return modifier.intensity;
         }
     }
+    return KeywordRules::defaultIntensity;
 }
 
-void KeywordMapper::processReverbKeywords(const juce::String& text, AudioParameters& params) {
-    // Check for removal first
-    bool removeReverb = text.contains("remove reverb") || text.contains("no reverb") || 
-                        text.contains("without reverb") || text.contains("take away reverb");
+void KeywordMapper::applyRules(const KeywordSet& found, AudioParameters& params, std::vector<ChangeLog>& changes) {
+    std::array<bool, KeywordRules::numChains> chainApplied {};
     
-    if (removeReverb) {
-        params.reverb.enabled = false;
-        params.reverb.wetLevel = 0.0f;
-        addChange("Reverb: Disabled", juce::Colour(0xff10b981));
-        return;
-    }
-    
-    // Check if reverb keywords are present (including "add reverb")
-    if (containsKeyword(text, reverbKeywords) || text.contains("add reverb") || 
-        text.contains("with reverb") || text.contains("put reverb")) {
-        params.reverb.enabled = true;
+    for (const auto& rule : KeywordRules::rules) {
+        const bool chained = rule.chain != KeywordRules::independent;
+        if (chained && chainApplied[(size_t)rule.chain]) continue;
         
-        if (text.contains("room") || text.contains("space") || text.contains("spacious")) {
-            params.reverb.roomSize = 0.4f;
-            params.reverb.damping = 0.3f;
-            params.reverb.wetLevel = 0.15f;
-            params.reverb.width = 0.8f;
-            addChange("Room Reverb: Wet 15%, Room 40%, Damping 30%", juce::Colour(0xff10b981));
-        } else if (text.contains("hall")) {
-            params.reverb.roomSize = 0.8f;
-            params.reverb.damping = 0.5f;
-            params.reverb.wetLevel = 0.25f;
-            params.reverb.width = 1.0f;
-            addChange("Hall Reverb: Wet 25%, Room 80%, Damping 50%", juce::Colour(0xff10b981));
-        } else if (text.contains("ambience") || text.contains("ambient")) {
-            params.reverb.roomSize = 0.3f;
-            params.reverb.damping = 0.4f;
-            params.reverb.wetLevel = 0.1f;
-            params.reverb.width = 0.9f;
-            addChange("Ambience: Wet 10%, Room 30%, Damping 40%", juce::Colour(0xff10b981));
-        } else {
-            // Default reverb when just "add reverb" or "reverb" is mentioned
-            params.reverb.roomSize = 0.4f;
-            params.reverb.damping = 0.3f;
-            params.reverb.wetLevel = 0.2f;
-            params.reverb.width = 0.9f;
-            addChange("Reverb: Wet 20%, Room 40%, Damping 30%", juce::Colour(0xff10b981));
-        }
-    }
-    
-    if (text.contains("dry") || text.contains("close") || text.contains("upfront")) {
-        params.reverb.enabled = true;
-        params.reverb.wetLevel = 0.05f;
-        params.reverb.dryLevel = 0.95f;
-        addChange("Dry Mix: Wet 5%", juce::Colour(0xff10b981));
-    }
-}
-
-void KeywordMapper::processCompressorKeywords(const juce::String& text, AudioParameters& params) {
-    if (containsKeyword(text, compressorKeywords)) {
-        params.compressor.enabled = true;
+        if (!found.containsAny(rule.anyOf) || found.containsAny(rule.noneOf)) continue;
+        if (!conditionHolds(rule.condition, params)) continue;
         
-        // Check for punch - but only if it's not in the context of bass (bass punch = different meaning)
-        if ((text.contains("punch") || text.contains("punchy")) && !text.contains("bass") && !text.contains("kick")) {
-            params.compressor.threshold = -12.0f;
-            params.compressor.ratio = 4.0f;
-            params.compressor.attack = 3.0f;
-            params.compressor.release = 60.0f;
-            params.compressor.makeupGain = 2.0f;
-            addChange("Compressor: Ratio 4:1, Attack 3ms, Release 60ms, +2dB makeup", juce::Colour(0xffff6b35));
-        } 
-        else if (text.contains("glue") || text.contains("tight") || text.contains("tighter")) {
-            params.compressor.threshold = -8.0f;
-            params.compressor.ratio = 2.5f;
-            params.compressor.attack = 10.0f;
-            params.compressor.release = 100.0f;
-            params.compressor.makeupGain = 1.0f;
-            addChange("Compressor: Ratio 2.5:1, Attack 10ms, Release 100ms", juce::Colour(0xffff6b35));
-        } 
-        else if (text.contains("level") || text.contains("leveled") || text.contains("even") || 
-                 text.contains("consistent") || text.contains("control") || text.contains("controlled")) {
-            params.compressor.threshold = -10.0f;
-            params.compressor.ratio = 3.0f;
-            params.compressor.attack = 20.0f;
-            params.compressor.release = 150.0f;
-            params.compressor.makeupGain = 1.5f;
-            addChange("Compressor: Ratio 3:1, Attack 20ms, Release 150ms", juce::Colour(0xffff6b35));
-        }
-        else {
-            // Default compression if keyword is present but no specific type matched
-            params.compressor.threshold = -10.0f;
-            params.compressor.ratio = 3.0f;
-            params.compressor.attack = 15.0f;
-            params.compressor.release = 100.0f;
-            params.compressor.makeupGain = 1.0f;
-            addChange("Compressor: Ratio 3:1 (default)", juce::Colour(0xffff6b35));
-        }
-    }
-}
-
-void KeywordMapper::processBassKeywords(const juce::String& text, AudioParameters& params) {
-    bool bassApplied = false;
-    
-    // Check for removal first
-    if (text.contains("remove bass") || text.contains("no bass") || text.contains("without bass") ||
-        text.contains("take away bass") || text.contains("cut bass")) {
-        params.eq.lowShelfFreq = 100.0f;
-        params.eq.lowShelfGain = -5.0f;
-        addChange("Low Shelf 100Hz -5.0dB (removed)", juce::Colour(0xff4fc3f7));
-        bassApplied = true;
-    }
-    // Check for specific bass reduction keywords
-    else if (text.contains("boom") || text.contains("boomy") || text.contains("reduce bass") || 
-             text.contains("less bass") || text.contains("lower bass")) {
-        params.eq.lowShelfFreq = 150.0f;
-        params.eq.lowShelfGain = -3.0f;
-        addChange("Low Shelf 150Hz -3.0dB", juce::Colour(0xff4fc3f7));
-        bassApplied = true;
-    }
-    // Check for deep bass keywords
-    else if (text.contains("deeper") || text.contains("deep bass") || text.contains("sub") || 
-             text.contains("add bass") || text.contains("more bass")) {
-        params.eq.lowShelfFreq = 60.0f;
-        params.eq.lowShelfGain = 3.0f;
-        addChange("Low Shelf 60Hz +3.0dB", juce::Colour(0xff4fc3f7));
-        bassApplied = true;
-    }
-    // General bass boost
-    else if (containsKeyword(text, bassKeywords)) {
-        params.eq.lowShelfFreq = 100.0f;
-        params.eq.lowShelfGain = 4.0f;
-        addChange("Low Shelf 100Hz +4.0dB", juce::Colour(0xff4fc3f7));
-        bassApplied = true;
-    }
-}
-
-void KeywordMapper::processPresenceKeywords(const juce::String& text, AudioParameters& params) {
-    if (containsKeyword(text, presenceKeywords)) {
-        // Only apply presence if mid frequency hasn't been set by warmth keywords
-        // (warmth uses lower frequencies, presence uses higher)
-        if (params.eq.midFreq < 2000.0f) {
-            // Warmth was already applied, don't override
-            return;
+        for (const auto& setting : rule.settings) {
+            setParameter(params, setting.parameter, setting.value);
         }
+        changes.push_back({rule.change, juce::Colour(rule.colour)});
         
-        if (text.contains("snap") || text.contains("snappy")) {
-            params.eq.midFreq = 4000.0f;
-            params.eq.midGain = 2.5f;
-            params.eq.midQ = 2.5f;
-            addChange("Peak 4kHz +2.5dB Q:2.5", juce::Colour(0xffffb74d));
-        }
-        else if (text.contains("presence") || text.contains("forward") || text.contains("vocal") || 
-                 text.contains("upfront") || text.contains("cut") || text.contains("cut through")) {
-            params.eq.midFreq = 3000.0f;
-            params.eq.midGain = 3.0f;
-            params.eq.midQ = 2.0f;
-            addChange("Peak 3kHz +3.0dB Q:2.0", juce::Colour(0xffffb74d));
-        }
-        else if (text.contains("mid") || text.contains("mids") || text.contains("midrange")) {
-            params.eq.midFreq = 2500.0f;
-            params.eq.midGain = 2.0f;
-            params.eq.midQ = 1.5f;
-            addChange("Peak 2.5kHz +2.0dB Q:1.5", juce::Colour(0xffffb74d));
+        if (chained) {
+            chainApplied[(size_t)rule.chain] = true;
         }
     }
 }
 
 void KeywordMapper::addChange(const juce::String& description, const juce::Colour& color) {
+    const juce::ScopedLock lock(resultLock);
     recentChanges.push_back({description, color});
 }
 
 std::vector<ChangeLog> KeywordMapper::getRecentChanges() const {
+    const juce::ScopedLock lock(resultLock);
     return recentChanges;
 }
 
+MappedText KeywordMapper::getLastMapped() const {
+    const juce::ScopedLock lock(resultLock);
+    return lastMapped;
+}
+
 KeywordMapper::~KeywordMapper() {
     geminiClient = nullptr; // Will be destroyed automatically via unique_ptr
 }
@@ -358,6 +195,8 @@ void KeywordMapper::setGeminiApiKey(const juce::String& apiKey) {
     if (apiKey.trim().isNotEmpty()) {
         if (!geminiClient) {
             geminiClient = std::make_unique<GeminiClient>();
+            geminiClient->setEndpoint(geminiEndpoint);
+            geminiClient->setPersistentCacheFile(geminiCacheFile);
         }
         geminiClient->setApiKey(apiKey);
     } else {
@@ -365,22 +204,40 @@ void KeywordMapper::setGeminiApiKey(const juce::String& apiKey) {
     }
 }
 
+void KeywordMapper::setGeminiCacheFile(const juce::File& file) {
+    geminiCacheFile = file;
+    
+    if (geminiClient) {
+        geminiClient->setPersistentCacheFile(geminiCacheFile);
+    }
+}
+
+void KeywordMapper::setGeminiEndpoint(const juce::String& generateContentUrl) {
+    geminiEndpoint = generateContentUrl;
+    
+    if (geminiClient) {
+        geminiClient->setEndpoint(geminiEndpoint);
+    }
+}
+
 bool KeywordMapper::isGeminiEnabled() const {
     return geminiClient != nullptr && geminiClient->isApiKeySet();
 }
 
-void KeywordMapper::processTextWithGemini(const juce::String& text, 
-                                           float baseIntensity,
-                                           std::function<void(const AudioParameters&)> callback) {
+void KeywordMapper::processTextWithGemini(const juce::String& text,
+                                           std::function<void(const MappedText&)> callback) {
     // Capture text by value for the lambda
     juce::String textCopy = text;
+    const juce::int64 request = startRequest();
     
     // If Gemini is not enabled, fall back to direct processing
     if (!isGeminiEnabled()) {
-        addChange("Gemini not enabled, using direct keyword mapping", juce::Colours::orange);
-        AudioParameters params = processText(textCopy, baseIntensity);
+        std::vector<ChangeLog> changes { {"Gemini not enabled, using direct keyword mapping", juce::Colours::orange} };
+        const MappedText mapped = mapKeywords(textCopy, changes);
+        if (!publish(mapped, std::move(changes), request))
+            return;
         if (callback) {
-            callback(params);
+            callback(mapped);
         }
         return;
     }
@@ -389,28 +246,64 @@ void KeywordMapper::processTextWithGemini(const juce::String& text,
     addChange("Processing with Gemini LLM...", juce::Colours::yellow);
     
     // Use Gemini to pre-process the text
-    geminiClient->processTextAsync(textCopy, [this, textCopy, baseIntensity, callback](bool success, const juce::String& processedText, const juce::String& error) {
+    // The answer arrives on the Gemini thread: the mapping and its change
+    // log are built locally and only published once complete
+    geminiClient->processTextAsync(textCopy, [this, textCopy, callback, request](bool success, const juce::String& processedText, const juce::String& error) {
+        std::vector<ChangeLog> changes;
+        MappedText mapped;
+        
         if (success && processedText.isNotEmpty()) {
             // Process the Gemini-enhanced text through keyword mapper
-            addChange("Gemini: " + processedText, juce::Colours::lightgreen);
-            AudioParameters params = processText(processedText, baseIntensity);
-            if (callback) {
-                callback(params);
-            }
+            changes.push_back({"Gemini: " + processedText, juce::Colours::lightgreen});
+            mapped = mapKeywords(processedText, changes);
         } else {
             // Gemini failed, fall back to direct keyword processing
             // Log the error for debugging
             juce::String errorMsg = error.isNotEmpty() ? error : "Unknown error";
-            addChange("LLM failed: " + errorMsg + " (using direct mapping)", juce::Colours::orange);
-            AudioParameters params = processText(textCopy, baseIntensity);
-            if (callback) {
-                callback(params);
-            }
+            changes.push_back({"LLM failed: " + errorMsg + " (using direct mapping)", juce::Colours::orange});
+            mapped = mapKeywords(textCopy, changes);
+        }
+        
+        // Superseded while Gemini was busy: neither the change log nor the
+        // caller hear of it
+        if (!publish(mapped, std::move(changes), request))
+            return;
+        if (callback) {
+            callback(mapped);
         }
     });
 }
 
+void KeywordMapper::cancelGeminiRequests() {
+    startRequest();
+    
+    if (geminiClient != nullptr)
+        geminiClient->cancelPendingRequests();
+}
+
+juce::StringArray KeywordMapper::prepareTextsWithGemini(const juce::StringArray& texts) {
+    if (!isGeminiEnabled()) {
+        return texts;
+    }
+    
+    juce::StringArray processedTexts;
+    juce::Array<bool> succeeded;
+    geminiClient->processTextsSync(texts, processedTexts, succeeded);
+    return processedTexts;
+}
+
+std::vector<AudioParameters> KeywordMapper::processTextsWithGemini(const juce::StringArray& texts, float baseIntensity) {
+    std::vector<AudioParameters> results;
+    results.reserve((size_t)texts.size());
+    
+    for (const auto& text : prepareTextsWithGemini(texts)) {
+        results.push_back(processText(text, baseIntensity));
+    }
+    return results;
+}
+
 void KeywordMapper::reset() {
+    const juce::ScopedLock lock(resultLock);
     recentChanges.clear();
 }
 
@@ -3,6 +3,9 @@
 #include <juce_core/juce_core.h>
 #include <juce_graphics/juce_graphics.h>
 #include "ChangesLogger.h"
+#include "AudioParameters.h"
+#include "KeywordMatcher.h"
+#include <functional>
 #include <map>
 #include <vector>
 #include <memory>
@@ -10,56 +13,50 @@
 // Forward declaration
 class GeminiClient;
 
-struct AudioParameters {
-    // EQ Parameters
-    struct EQ {
-        float highShelfFreq = 10000.0f;
-        float highShelfGain = 0.0f;
-        float midFreq = 2000.0f;
-        float midGain = 0.0f;
-        float midQ = 1.0f;
-        float lowShelfFreq = 100.0f;
-        float lowShelfGain = 0.0f;
-    } eq;
-    
-    // Compressor Parameters
-    struct Compressor {
-        float threshold = 0.0f;
-        float ratio = 1.0f;
-        float attack = 10.0f;
-        float release = 100.0f;
-        float makeupGain = 0.0f;
-        bool enabled = false;
-    } compressor;
-    
-    // Reverb Parameters
-    struct Reverb {
-        float roomSize = 0.0f;
-        float damping = 0.0f;
-        float width = 1.0f;
-        float wetLevel = 0.0f;
-        float dryLevel = 1.0f;
-        bool enabled = false;
-    } reverb;
-    
-    float intensity = 1.0f; // Global intensity multiplier
+// A prompt's meaning before the intensity slider is applied: the parameters
+// its keywords set at nominal strength, and the strength its own modifiers
+// ("slightly", "very", "remove"...) ask for
+struct MappedText {
+    AudioParameters nominal;
+    float keywordIntensity = 1.0f;
 };
 
-
 class KeywordMapper {
 public:
     KeywordMapper();
     ~KeywordMapper();
     
     // Process text input and return audio parameters
+    // (same as applyIntensity(mapText(text), baseIntensity))
     AudioParameters processText(const juce::String& text, float baseIntensity = 1.0f);
     
+    // The keyword pass on its own; also refreshes the change log, and
+    // supersedes any Gemini request still running
+    MappedText mapText(const juce::String& text);
+    
+    // Scale a mapped prompt by the intensity slider. Touches only a handful
+    // of parameters, so it's cheap enough for every slider tick
+    static AudioParameters applyIntensity(const MappedText& mapped, float baseIntensity);
+    
     // Process text with Gemini LLM enhancement (async)
     // If Gemini is configured, it will pre-process the text before keyword mapping
-    // If Gemini fails or isn't configured, falls back to direct keyword mapping
-    void processTextWithGemini(const juce::String& text, 
-                                float baseIntensity,
-                                std::function<void(const AudioParameters&)> callback);
+    // If Gemini fails or isn't configured, falls back to direct keyword mapping.
+    // The callback gets the mapping (before intensity), usually on the Gemini
+    // thread; the change log is updated before it runs. A later call, mapText
+    // or cancelGeminiRequests supersedes the request, and its callback never runs
+    void processTextWithGemini(const juce::String& text,
+                                std::function<void(const MappedText&)> callback);
+    
+    // Drop the Gemini request in progress, if any, without mapping anything
+    void cancelGeminiRequests();
+    
+    // Rewrite many prompts through Gemini in a few batched requests (blocks).
+    // Returns one text per prompt, ready for processText: Gemini's keywords,
+    // or the original prompt where Gemini isn't enabled or couldn't help
+    juce::StringArray prepareTextsWithGemini(const juce::StringArray& texts);
+    
+    // Map many prompts at once, via prepareTextsWithGemini
+    std::vector<AudioParameters> processTextsWithGemini(const juce::StringArray& texts, float baseIntensity = 1.0f);
     
     // Set Gemini API key to enable LLM processing
     // Get your free API key from: https://aistudio.google.com/api-keys
@@ -68,37 +65,55 @@ public:
     // Check if Gemini is enabled
     bool isGeminiEnabled() const;
     
-    // Get list of changes that were applied
+    // Persist Gemini's processed prompts next to this file between sessions
+    // (they are always cached in memory); off until set
+    void setGeminiCacheFile(const juce::File& file);
+    
+    // Send Gemini requests somewhere other than Google, e.g. a local mock
+    // server; empty restores the default endpoint
+    void setGeminiEndpoint(const juce::String& generateContentUrl);
+    
+    // Get list of changes that were applied; safe from any thread
     std::vector<ChangeLog> getRecentChanges() const;
     
+    // What mapText last produced, from Gemini's keywords after a successful
+    // Gemini round trip, otherwise from the prompt itself; safe from any thread
+    MappedText getLastMapped() const;
+    
     // Reset all parameters
     void reset();
     
 private:
+    // Written from the message thread and the Gemini thread, so a mapping
+    // is built on its own and then published here in one go
+    mutable juce::CriticalSection resultLock;
     std::vector<ChangeLog> recentChanges;
+    MappedText lastMapped;
+    
+    // Numbers each mapping; only the newest may publish
+    juce::int64 latestRequest = 0;
     
     // Gemini client for LLM processing (optional)
     std::unique_ptr<GeminiClient> geminiClient;
+    juce::File geminiCacheFile;
+    juce::String geminiEndpoint;
+    
+    // The keyword pass, touching nothing but its arguments; each rule that
+    // fires is appended to changes
+    static MappedText mapKeywords(const juce::String& text, std::vector<ChangeLog>& changes);
+    
+    // Supersedes every earlier request; returns the new request's number
+    juce::int64 startRequest();
+    
+    // Makes a finished mapping the last one, with its change log, unless a
+    // newer request has started since; returns whether it did
+    bool publish(const MappedText& mapped, std::vector<ChangeLog> changes, juce::int64 request);
     
     // Keyword detection functions
-    bool containsKeyword(const juce::String& text, const std::vector<juce::String>& keywords);
-    float extractIntensity(const juce::String& text);
-    
-    // Processing functions for each effect type
-    void processBrightnessKeywords(const juce::String& text, AudioParameters& params);
-    void processWarmthKeywords(const juce::String& text, AudioParameters& params);
-    void processReverbKeywords(const juce::String& text, AudioParameters& params);
-    void processCompressorKeywords(const juce::String& text, AudioParameters& params);
-    void processBassKeywords(const juce::String& text, AudioParameters& params);
-    void processPresenceKeywords(const juce::String& text, AudioParameters& params);
-    
-    // Keyword lists
-    std::vector<juce::String> brightnessKeywords;
-    std::vector<juce::String> warmthKeywords;
-    std::vector<juce::String> reverbKeywords;
-    std::vector<juce::String> compressorKeywords;
-    std::vector<juce::String> bassKeywords;
-    std::vector<juce::String> presenceKeywords;
+    static float extractIntensity(const KeywordSet& found);
+    
+    // Runs the KeywordRules table against the keywords found in the text
+    static void applyRules(const KeywordSet& found, AudioParameters& params, std::vector<ChangeLog>& changes);
     
     // Helper to add change log
     void addChange(const juce::String& description, const juce::Colour& color = juce::Colours::white);
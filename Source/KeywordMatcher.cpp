@@ -0,0 +1,144 @@
+#include "KeywordMatcher.h"
+#include <queue>
+#include <string_view>
+
+namespace {
+    // Spelling of every Keyword, in enum order
+    constexpr std::string_view patterns[] = {
+        // Intensity modifiers
+        "remove", "no ", "without", "take away", "eliminate", "cut",
+        "slight", "little", "bit", "more", "much", "add", "very", "super", "extreme",
+        "less", "reduce", "lower", "decrease",
+
+        // Brightness
+        "bright", "brighter", "brightness", "sparkle", "sparkly", "air", "airy", "airiness",
+        "crisp", "crispy", "highs", "high end", "treble", "presence", "shine", "shiny",
+        "clear", "clearer", "clarity", "detail", "detailed", "more air",
+        "remove bright", "no bright", "without bright", "take away bright", "remove highs", "cut highs",
+        "dull", "dark", "muddy", "less bright", "reduce bright",
+
+        // Warmth
+        "warm", "warmer", "warmth", "smooth", "smoother", "body", "full", "fuller",
+        "thick", "thicker", "round", "rounder", "mellow", "soft", "softer", "sweet",
+
+        // Reverb
+        "reverb", "verb", "room", "space", "spacious", "hall", "ambience", "ambient",
+        "distance", "distant", "echo", "echoes", "wet", "wetness", "atmosphere", "atmospheric",
+        "add reverb", "with reverb", "put reverb",
+        "remove reverb", "no reverb", "without reverb", "take away reverb",
+        "dry", "close", "upfront",
+
+        // Compression
+        "punch", "punchy", "tight", "tighter", "glue", "glued", "glue the mix", "cohesion",
+        "consistent", "consistent dynamics", "control", "controlled", "compression", "compress",
+        "even", "even dynamics", "level", "leveled",
+
+        // Bass
+        "bass", "low end", "lows", "low", "deeper", "deep", "boom", "boomy", "thump", "thumpy",
+        "kick", "weight", "heavy", "sub", "deep bass", "add bass", "more bass",
+        "remove bass", "no bass", "without bass", "take away bass", "cut bass",
+        "reduce bass", "less bass", "lower bass",
+
+        // Presence
+        "forward", "cut through", "vocal", "vocals", "mid", "mids", "midrange", "snap", "snappy"
+    };
+
+    static_assert(sizeof(patterns) / sizeof(patterns[0]) == (size_t)Keyword::numKeywords,
+                  "Every Keyword needs exactly one pattern");
+
+    // The automaton's alphabet is lowercase a-z and space
+    constexpr bool patternsUseAlphabet() {
+        for (auto pattern : patterns) {
+            if (pattern.empty()) return false;
+            for (char c : pattern)
+                if (!((c >= 'a' && c <= 'z') || c == ' ')) return false;
+        }
+        return true;
+    }
+
+    static_assert(patternsUseAlphabet(), "Patterns must be non-empty lowercase letters and spaces");
+}
+
+const KeywordMatcher& KeywordMatcher::getInstance() {
+    static const KeywordMatcher instance;
+    return instance;
+}
+
+int KeywordMatcher::symbolFor(juce::uint8 c) {
+    if (c >= 'a' && c <= 'z') return c - 'a' + 1;
+    if (c >= 'A' && c <= 'Z') return c - 'A' + 1;
+    if (c == ' ') return alphabetSize - 1;
+    return 0;
+}
+
+KeywordMatcher::KeywordMatcher() {
+    // Trie of all patterns; -1 marks a missing edge until failure links fill it in
+    std::vector<int> trie(alphabetSize, -1);
+    outputs.resize(1);
+
+    for (size_t keyword = 0; keyword < (size_t)Keyword::numKeywords; ++keyword) {
+        int state = 0;
+        for (char c : patterns[keyword]) {
+            const int symbol = symbolFor((juce::uint8)c);
+
+            int& next = trie[(size_t)(state * alphabetSize + symbol)];
+            if (next < 0) {
+                next = (int)outputs.size();
+                outputs.emplace_back();
+                trie.resize(trie.size() + alphabetSize, -1);
+            }
+            state = trie[(size_t)(state * alphabetSize + symbol)];
+        }
+        outputs[(size_t)state].add((Keyword)keyword);
+    }
+
+    // Breadth-first over the trie: missing edges borrow the failure state's
+    // edge, and each state also reports whatever its failure state reports
+    const size_t numStates = outputs.size();
+    std::vector<int> failure(numStates, 0);
+    std::queue<int> pending;
+
+    for (int symbol = 0; symbol < alphabetSize; ++symbol) {
+        int& next = trie[(size_t)symbol];
+        if (next < 0) {
+            next = 0;
+        } else {
+            failure[(size_t)next] = 0;
+            pending.push(next);
+        }
+    }
+
+    while (!pending.empty()) {
+        const int state = pending.front();
+        pending.pop();
+        outputs[(size_t)state].addAll(outputs[(size_t)failure[(size_t)state]]);
+
+        for (int symbol = 0; symbol < alphabetSize; ++symbol) {
+            int& next = trie[(size_t)(state * alphabetSize + symbol)];
+            const int fallback = trie[(size_t)(failure[(size_t)state] * alphabetSize + symbol)];
+
+            if (next < 0) {
+                next = fallback;
+            } else {
+                failure[(size_t)next] = fallback;
+                pending.push(next);
+            }
+        }
+    }
+
+    jassert(numStates <= 0xffff);
+    transitions.assign(trie.begin(), trie.end());
+}
+
+KeywordSet KeywordMatcher::findAll(const juce::String& text) const {
+    KeywordSet found;
+    std::uint16_t state = 0;
+
+    // Case folding happens per byte here, so the text is never copied
+    for (auto* c = text.toRawUTF8(); *c != 0; ++c) {
+        state = transitions[(size_t)state * alphabetSize + (size_t)symbolFor((juce::uint8)*c)];
+        found.addAll(outputs[state]);
+    }
+
+    return found;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+// Every word and phrase KeywordMapper reacts to. The spelling of each one is
+// in the pattern table in KeywordMatcher.cpp, in the same order.
+enum class Keyword {
+    // Intensity modifiers
+    remove, noWord, without, takeAway, eliminate, cut,
+    slight, little, bit, more, much, add, very, super, extreme,
+    less, reduce, lower, decrease,
+
+    // Brightness
+    bright, brighter, brightness, sparkle, sparkly, air, airy, airiness,
+    crisp, crispy, highs, highEnd, treble, presence, shine, shiny,
+    clear, clearer, clarity, detail, detailed, moreAir,
+    removeBright, noBright, withoutBright, takeAwayBright, removeHighs, cutHighs,
+    dull, dark, muddy, lessBright, reduceBright,
+
+    // Warmth
+    warm, warmer, warmth, smooth, smoother, body, full, fuller,
+    thick, thicker, round, rounder, mellow, soft, softer, sweet,
+
+    // Reverb
+    reverb, verb, room, space, spacious, hall, ambience, ambient,
+    distance, distant, echo, echoes, wet, wetness, atmosphere, atmospheric,
+    addReverb, withReverb, putReverb,
+    removeReverb, noReverb, withoutReverb, takeAwayReverb,
+    dry, close, upfront,
+
+    // Compression
+    punch, punchy, tight, tighter, glue, glued, glueTheMix, cohesion,
+    consistent, consistentDynamics, control, controlled, compression, compress,
+    even, evenDynamics, level, leveled,
+
+    // Bass
+    bass, lowEnd, lows, low, deeper, deep, boom, boomy, thump, thumpy,
+    kick, weight, heavy, sub, deepBass, addBass, moreBass,
+    removeBass, noBass, withoutBass, takeAwayBass, cutBass,
+    reduceBass, lessBass, lowerBass,
+
+    // Presence
+    forward, cutThrough, vocal, vocals, mid, mids, midrange, snap, snappy,
+
+    numKeywords
+};
+
+// Which keywords occur in a piece of text. Usable in constant expressions,
+// so keyword groups can be written as constexpr tables.
+class KeywordSet {
+public:
+    constexpr KeywordSet() = default;
+    constexpr KeywordSet(std::initializer_list<Keyword> keywords) {
+        for (auto keyword : keywords)
+            add(keyword);
+    }
+
+    constexpr void add(Keyword keyword) {
+        words[(size_t)keyword / 64] |= std::uint64_t(1) << ((size_t)keyword % 64);
+    }
+
+    constexpr void addAll(const KeywordSet& other) {
+        for (size_t i = 0; i < numWords; ++i)
+            words[i] |= other.words[i];
+    }
+
+    constexpr bool contains(Keyword keyword) const {
+        return (words[(size_t)keyword / 64] >> ((size_t)keyword % 64)) & 1;
+    }
+
+    constexpr bool containsAny(const KeywordSet& other) const {
+        for (size_t i = 0; i < numWords; ++i)
+            if ((words[i] & other.words[i]) != 0)
+                return true;
+        return false;
+    }
+
+    constexpr bool isEmpty() const {
+        return !containsAny(all());
+    }
+
+    friend constexpr KeywordSet operator|(KeywordSet a, const KeywordSet& b) {
+        a.addAll(b);
+        return a;
+    }
+
+private:
+    static constexpr size_t numWords = ((size_t)Keyword::numKeywords + 63) / 64;
+    std::array<std::uint64_t, numWords> words {};
+
+    static constexpr KeywordSet all() {
+        KeywordSet set;
+        for (auto& word : set.words)
+            word = ~std::uint64_t(0);
+        return set;
+    }
+};
+
+// Aho-Corasick automaton over every Keyword pattern. One pass over the text
+// finds all of them at once, with the same answers as calling
+// text.toLowerCase().contains(pattern) for each pattern in turn.
+class KeywordMatcher {
+public:
+    // Built on first use and shared by every KeywordMapper
+    static const KeywordMatcher& getInstance();
+
+    KeywordSet findAll(const juce::String& text) const;
+
+private:
+    KeywordMatcher();
+
+    // Patterns only contain a-z and spaces; everything else is symbol 0,
+    // which no pattern uses and so always leads back to the root
+    static constexpr int alphabetSize = 28;
+    static int symbolFor(juce::uint8 c);
+
+    // Dense transition table (state * alphabetSize + symbol), with failure
+    // links already folded in, and the keywords that end at each state
+    std::vector<std::uint16_t> transitions;
+    std::vector<KeywordSet> outputs;
+};
@@ -0,0 +1,246 @@
+#pragma once
+
+#include "KeywordMatcher.h"
+#include <array>
+#include <limits>
+
+// KeywordMapper's whole rule set as compile-time data. processText() walks
+// these tables in order against the keywords found in the prompt; nothing
+// here is built or allocated at runtime.
+namespace KeywordRules {
+    // Everything a rule can set in AudioParameters. Switches are set with
+    // 1 (on) or 0 (off).
+    enum class Parameter {
+        none,
+        highShelfFreq, highShelfGain,
+        midFreq, midGain, midQ,
+        lowMidFreq, lowMidGain, lowMidQ,
+        lowShelfFreq, lowShelfGain,
+        compressorThreshold, compressorRatio, compressorAttack, compressorRelease,
+        compressorMakeupGain, compressorEnabled,
+        reverbRoomSize, reverbDamping, reverbWidth, reverbWetLevel, reverbDryLevel, reverbEnabled
+    };
+
+    struct Setting {
+        Parameter parameter = Parameter::none;
+        float value = 0.0f;
+    };
+
+    // Rule only applies while a parameter set by an earlier rule is in range
+    struct Condition {
+        Parameter parameter = Parameter::none;
+        float min = std::numeric_limits<float>::lowest();
+        float max = std::numeric_limits<float>::max();
+    };
+
+    // Within a chain only the first rule that matches applies, like an
+    // if/else-if ladder; independent rules are checked on their own
+    enum Chain {
+        independent = -1,
+        brightnessChain,
+        reverbChain,
+        compressorChain,
+        bassChain,
+        presenceChain,
+        numChains
+    };
+
+    struct Rule {
+        int chain;
+        KeywordSet anyOf;               // fires when any of these was found...
+        KeywordSet noneOf;              // ...and none of these were
+        Condition condition;
+        std::array<Setting, 6> settings;
+        const char* change;             // shown in the changes log
+        juce::uint32 colour;
+    };
+
+    // Colour of each category in the changes log
+    constexpr juce::uint32 brightnessColour = 0xff8affb4;
+    constexpr juce::uint32 warmthColour = 0xffa78bfa;
+    constexpr juce::uint32 reverbColour = 0xff10b981;
+    constexpr juce::uint32 compressorColour = 0xffff6b35;
+    constexpr juce::uint32 bassColour = 0xff4fc3f7;
+    constexpr juce::uint32 presenceColour = 0xffffb74d;
+
+    // Keyword groups: a category reacts when any of its keywords was found
+    constexpr KeywordSet brightnessKeywords {
+        Keyword::bright, Keyword::brighter, Keyword::brightness, Keyword::sparkle, Keyword::sparkly,
+        Keyword::air, Keyword::airy, Keyword::airiness, Keyword::crisp, Keyword::crispy, Keyword::highs,
+        Keyword::highEnd, Keyword::treble, Keyword::presence, Keyword::shine, Keyword::shiny,
+        Keyword::clear, Keyword::clearer, Keyword::clarity, Keyword::detail, Keyword::detailed
+    };
+
+    constexpr KeywordSet warmthKeywords {
+        Keyword::warm, Keyword::warmer, Keyword::warmth, Keyword::smooth, Keyword::smoother, Keyword::body,
+        Keyword::full, Keyword::fuller, Keyword::thick, Keyword::thicker, Keyword::round, Keyword::rounder,
+        Keyword::mellow, Keyword::soft, Keyword::softer, Keyword::sweet
+    };
+
+    constexpr KeywordSet reverbKeywords {
+        Keyword::reverb, Keyword::verb, Keyword::room, Keyword::space, Keyword::spacious, Keyword::hall,
+        Keyword::ambience, Keyword::ambient, Keyword::distance, Keyword::distant, Keyword::echo,
+        Keyword::echoes, Keyword::wet, Keyword::wetness, Keyword::atmosphere, Keyword::atmospheric,
+        Keyword::addReverb, Keyword::withReverb, Keyword::putReverb
+    };
+
+    constexpr KeywordSet compressorKeywords {
+        Keyword::punch, Keyword::punchy, Keyword::tight, Keyword::tighter, Keyword::glue, Keyword::glued,
+        Keyword::glueTheMix, Keyword::cohesion, Keyword::consistent, Keyword::consistentDynamics,
+        Keyword::control, Keyword::controlled, Keyword::compression, Keyword::compress,
+        Keyword::even, Keyword::evenDynamics, Keyword::level, Keyword::leveled
+    };
+
+    constexpr KeywordSet bassKeywords {
+        Keyword::bass, Keyword::lowEnd, Keyword::lows, Keyword::low, Keyword::deeper, Keyword::deep,
+        Keyword::boom, Keyword::boomy, Keyword::thump, Keyword::thumpy, Keyword::kick, Keyword::punch,
+        Keyword::weight, Keyword::heavy, Keyword::thick
+    };
+
+    constexpr KeywordSet presenceKeywords {
+        Keyword::presence, Keyword::forward, Keyword::upfront, Keyword::cut, Keyword::cutThrough,
+        Keyword::vocal, Keyword::vocals, Keyword::mid, Keyword::mids, Keyword::midrange,
+        Keyword::snap, Keyword::snappy
+    };
+
+    constexpr KeywordSet removeBrightness {
+        Keyword::removeBright, Keyword::noBright, Keyword::withoutBright,
+        Keyword::removeHighs, Keyword::cutHighs, Keyword::takeAwayBright
+    };
+
+    constexpr KeywordSet darken {
+        Keyword::dull, Keyword::dark, Keyword::muddy, Keyword::lessBright, Keyword::reduceBright
+    };
+
+    constexpr KeywordSet removeReverb {
+        Keyword::removeReverb, Keyword::noReverb, Keyword::withoutReverb, Keyword::takeAwayReverb
+    };
+
+    // Global intensity from modifier words; the first entry that matches wins
+    struct Modifier {
+        KeywordSet anyOf;
+        float intensity;
+    };
+
+    constexpr Modifier modifiers[] = {
+        { { Keyword::remove, Keyword::noWord, Keyword::without, Keyword::takeAway, Keyword::eliminate, Keyword::cut }, -2.0f },
+        { { Keyword::slight, Keyword::little, Keyword::bit }, 0.5f },
+        { { Keyword::more, Keyword::much, Keyword::add }, 1.5f },
+        { { Keyword::very, Keyword::super, Keyword::extreme }, 2.0f },
+        { { Keyword::less, Keyword::reduce, Keyword::lower, Keyword::decrease }, -1.0f }
+    };
+
+    constexpr float defaultIntensity = 1.0f;
+
+    // Evaluated top to bottom; categories run brightness, warmth, reverb,
+    // compression, bass, presence so conditions see what earlier ones set
+    constexpr Rule rules[] = {
+        // Brightness: removal, then darkening, then the flavour of boost
+        { brightnessChain, removeBrightness, {}, {},
+          { { { Parameter::highShelfFreq, 8000.0f }, { Parameter::highShelfGain, -5.0f } } },
+          "High Shelf 8kHz -5.0dB (removed)", brightnessColour },
+        { brightnessChain, darken, {}, {},
+          { { { Parameter::highShelfFreq, 8000.0f }, { Parameter::highShelfGain, -3.0f } } },
+          "High Shelf 8kHz -3.0dB", brightnessColour },
+        { brightnessChain, { Keyword::moreAir, Keyword::airy, Keyword::airiness }, {}, {},
+          { { { Parameter::highShelfFreq, 10000.0f }, { Parameter::highShelfGain, 4.0f } } },
+          "High Shelf 10kHz +4.0dB", brightnessColour },
+        { brightnessChain, { Keyword::sparkle, Keyword::sparkly, Keyword::shine, Keyword::shiny }, {}, {},
+          { { { Parameter::highShelfFreq, 12000.0f }, { Parameter::highShelfGain, 3.0f } } },
+          "High Shelf 12kHz +3.0dB", brightnessColour },
+        { brightnessChain, { Keyword::crisp, Keyword::crispy, Keyword::highs, Keyword::treble }, {}, {},
+          { { { Parameter::highShelfFreq, 9000.0f }, { Parameter::highShelfGain, 3.0f } } },
+          "High Shelf 9kHz +3.0dB", brightnessColour },
+        { brightnessChain, brightnessKeywords, {}, {},
+          { { { Parameter::highShelfFreq, 8000.0f }, { Parameter::highShelfGain, 2.5f } } },
+          "High Shelf 8kHz +2.5dB", brightnessColour },
+
+        // Clarity rides along with a brightness boost, unless presence owns the mids
+        { independent, { Keyword::clarity, Keyword::clear, Keyword::clearer, Keyword::detail, Keyword::detailed },
+          removeBrightness | darken,
+          { Parameter::midFreq, std::numeric_limits<float>::lowest(), 2000.0f },
+          { { { Parameter::midFreq, 2500.0f }, { Parameter::midGain, 2.0f }, { Parameter::midQ, 1.5f } } },
+          "Peak 2.5kHz +2.0dB Q:1.5", brightnessColour },
+
+        // Warmth: each of these stacks on the others
+        { independent, { Keyword::warm, Keyword::warmth }, {}, {},
+          { { { Parameter::lowMidFreq, 800.0f }, { Parameter::lowMidGain, 2.0f }, { Parameter::lowMidQ, 1.0f } } },
+          "Peak 800Hz +2.0dB", warmthColour },
+        { independent, { Keyword::warm, Keyword::warmth }, {}, {},
+          { { { Parameter::highShelfFreq, 10000.0f }, { Parameter::highShelfGain, -1.5f } } },
+          "High Shelf 10kHz -1.5dB", warmthColour },
+        { independent, { Keyword::body, Keyword::full }, {}, {},
+          { { { Parameter::lowMidFreq, 300.0f }, { Parameter::lowMidGain, 3.0f }, { Parameter::lowMidQ, 1.5f } } },
+          "Peak 300Hz +3.0dB", warmthColour },
+        { independent, { Keyword::smooth }, {}, {},
+          { { { Parameter::highShelfFreq, 5000.0f }, { Parameter::highShelfGain, -2.0f } } },
+          "High Shelf 5kHz -2.0dB", warmthColour },
+
+        // Reverb: removal wins over everything, including "dry"
+        { reverbChain, removeReverb, {}, {},
+          { { { Parameter::reverbEnabled, 0.0f }, { Parameter::reverbWetLevel, 0.0f } } },
+          "Reverb: Disabled", reverbColour },
+        { reverbChain, { Keyword::room, Keyword::space, Keyword::spacious }, {}, {},
+          { { { Parameter::reverbEnabled, 1.0f }, { Parameter::reverbRoomSize, 0.4f }, { Parameter::reverbDamping, 0.3f },
+              { Parameter::reverbWetLevel, 0.15f }, { Parameter::reverbWidth, 0.8f } } },
+          "Room Reverb: Wet 15%, Room 40%, Damping 30%", reverbColour },
+        { reverbChain, { Keyword::hall }, {}, {},
+          { { { Parameter::reverbEnabled, 1.0f }, { Parameter::reverbRoomSize, 0.8f }, { Parameter::reverbDamping, 0.5f },
+              { Parameter::reverbWetLevel, 0.25f }, { Parameter::reverbWidth, 1.0f } } },
+          "Hall Reverb: Wet 25%, Room 80%, Damping 50%", reverbColour },
+        { reverbChain, { Keyword::ambience, Keyword::ambient }, {}, {},
+          { { { Parameter::reverbEnabled, 1.0f }, { Parameter::reverbRoomSize, 0.3f }, { Parameter::reverbDamping, 0.4f },
+              { Parameter::reverbWetLevel, 0.1f }, { Parameter::reverbWidth, 0.9f } } },
+          "Ambience: Wet 10%, Room 30%, Damping 40%", reverbColour },
+        { reverbChain, reverbKeywords, {}, {},
+          { { { Parameter::reverbEnabled, 1.0f }, { Parameter::reverbRoomSize, 0.4f }, { Parameter::reverbDamping, 0.3f },
+              { Parameter::reverbWetLevel, 0.2f }, { Parameter::reverbWidth, 0.9f } } },
+          "Reverb: Wet 20%, Room 40%, Damping 30%", reverbColour },
+        { independent, { Keyword::dry, Keyword::close, Keyword::upfront }, removeReverb, {},
+          { { { Parameter::reverbEnabled, 1.0f }, { Parameter::reverbWetLevel, 0.05f }, { Parameter::reverbDryLevel, 0.95f } } },
+          "Dry Mix: Wet 5%", reverbColour },
+
+        // Compression; "punch" next to bass words is left to the bass rules
+        { compressorChain, { Keyword::punch, Keyword::punchy }, { Keyword::bass, Keyword::kick }, {},
+          { { { Parameter::compressorEnabled, 1.0f }, { Parameter::compressorThreshold, -12.0f }, { Parameter::compressorRatio, 4.0f },
+              { Parameter::compressorAttack, 3.0f }, { Parameter::compressorRelease, 60.0f }, { Parameter::compressorMakeupGain, 2.0f } } },
+          "Compressor: Ratio 4:1, Attack 3ms, Release 60ms, +2dB makeup", compressorColour },
+        { compressorChain, { Keyword::glue, Keyword::tight, Keyword::tighter }, {}, {},
+          { { { Parameter::compressorEnabled, 1.0f }, { Parameter::compressorThreshold, -8.0f }, { Parameter::compressorRatio, 2.5f },
+              { Parameter::compressorAttack, 10.0f }, { Parameter::compressorRelease, 100.0f }, { Parameter::compressorMakeupGain, 1.0f } } },
+          "Compressor: Ratio 2.5:1, Attack 10ms, Release 100ms", compressorColour },
+        { compressorChain, { Keyword::level, Keyword::leveled, Keyword::even, Keyword::consistent, Keyword::control, Keyword::controlled }, {}, {},
+          { { { Parameter::compressorEnabled, 1.0f }, { Parameter::compressorThreshold, -10.0f }, { Parameter::compressorRatio, 3.0f },
+              { Parameter::compressorAttack, 20.0f }, { Parameter::compressorRelease, 150.0f }, { Parameter::compressorMakeupGain, 1.5f } } },
+          "Compressor: Ratio 3:1, Attack 20ms, Release 150ms", compressorColour },
+        { compressorChain, compressorKeywords, {}, {},
+          { { { Parameter::compressorEnabled, 1.0f }, { Parameter::compressorThreshold, -10.0f }, { Parameter::compressorRatio, 3.0f },
+              { Parameter::compressorAttack, 15.0f }, { Parameter::compressorRelease, 100.0f }, { Parameter::compressorMakeupGain, 1.0f } } },
+          "Compressor: Ratio 3:1 (default)", compressorColour },
+
+        // Bass: removal, then reduction, then deep, then a general boost
+        { bassChain, { Keyword::removeBass, Keyword::noBass, Keyword::withoutBass, Keyword::takeAwayBass, Keyword::cutBass }, {}, {},
+          { { { Parameter::lowShelfFreq, 100.0f }, { Parameter::lowShelfGain, -5.0f } } },
+          "Low Shelf 100Hz -5.0dB (removed)", bassColour },
+        { bassChain, { Keyword::boom, Keyword::boomy, Keyword::reduceBass, Keyword::lessBass, Keyword::lowerBass }, {}, {},
+          { { { Parameter::lowShelfFreq, 150.0f }, { Parameter::lowShelfGain, -3.0f } } },
+          "Low Shelf 150Hz -3.0dB", bassColour },
+        { bassChain, { Keyword::deeper, Keyword::deepBass, Keyword::sub, Keyword::addBass, Keyword::moreBass }, {}, {},
+          { { { Parameter::lowShelfFreq, 60.0f }, { Parameter::lowShelfGain, 3.0f } } },
+          "Low Shelf 60Hz +3.0dB", bassColour },
+        { bassChain, bassKeywords, {}, {},
+          { { { Parameter::lowShelfFreq, 100.0f }, { Parameter::lowShelfGain, 4.0f } } },
+          "Low Shelf 100Hz +4.0dB", bassColour },
+
+        // Presence has the upper mid band to itself; warmth lives in the lower one
+        { presenceChain, { Keyword::snap, Keyword::snappy }, {}, {},
+          { { { Parameter::midFreq, 4000.0f }, { Parameter::midGain, 2.5f }, { Parameter::midQ, 2.5f } } },
+          "Peak 4kHz +2.5dB Q:2.5", presenceColour },
+        { presenceChain, { Keyword::presence, Keyword::forward, Keyword::vocal, Keyword::upfront, Keyword::cut, Keyword::cutThrough }, {}, {},
+          { { { Parameter::midFreq, 3000.0f }, { Parameter::midGain, 3.0f }, { Parameter::midQ, 2.0f } } },
+          "Peak 3kHz +3.0dB Q:2.0", presenceColour },
+        { presenceChain, { Keyword::mid, Keyword::mids, Keyword::midrange }, {}, {},
+          { { { Parameter::midFreq, 2500.0f }, { Parameter::midGain, 2.0f }, { Parameter::midQ, 1.5f } } },
+          "Peak 2.5kHz +2.0dB Q:1.5", presenceColour }
+    };
+}
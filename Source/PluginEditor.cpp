@@ -16,12 +16,16 @@ SonaraAudioProcessorEditor::SonaraAudioProcessorEditor(SonaraAudioProcessor& p)
     // Setup text input
     textInput.setTextToShowWhenEmpty("Type your desired sound effect here...", juce::Colour(0x66999999));
     textInput.setFont(juce::Font(16.0f));
+    
+    // Show what a restored session is already playing, without re-processing it
+    lastProcessedText = audioProcessor.getPrompt().trim();
+    textInput.setText(audioProcessor.getPrompt(), juce::dontSendNotification);
     textInput.addListener(this);
     addAndMakeVisible(textInput);
     
     // Setup intensity slider
     intensitySlider.setRange(0.0, 2.0, 0.1);
-    intensitySlider.setValue(1.0);
+    intensitySlider.setValue(audioProcessor.getIntensity(), juce::dontSendNotification);
     intensitySlider.setSliderStyle(juce::Slider::LinearHorizontal);
     intensitySlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
     intensitySlider.addListener(this);
@@ -114,11 +118,21 @@ void SonaraAudioProcessorEditor::textEditorReturnKeyPressed(juce::TextEditor& ed
 
 void SonaraAudioProcessorEditor::textEditorTextChanged(juce::TextEditor& editor)
 {
-    // Process immediately when text changes (user-friendly)
     if (&editor == &textInput)
     {
-        // Process right away so user sees immediate feedback
-        processTextInput();
+        // Wait for a pause in typing rather than mapping (and asking Gemini
+        // about) every keystroke, but don't leave long bursts unprocessed
+        const auto now = juce::Time::getMillisecondCounter();
+        if (!hasPendingEdit)
+        {
+            hasPendingEdit = true;
+            firstPendingEditTime = now;
+        }
+        
+        if (now - firstPendingEditTime >= (juce::uint32)maxWaitMs)
+            processTextInput();
+        else
+            startTimer(debounceMs);
     }
 }
 
@@ -131,9 +145,21 @@ void SonaraAudioProcessorEditor::textEditorFocusLost(juce::TextEditor& editor)
     }
 }
 
+void SonaraAudioProcessorEditor::timerCallback()
+{
+    processTextInput();
+}
+
 void SonaraAudioProcessorEditor::processTextInput()
 {
+    stopTimer();
+    hasPendingEdit = false;
+    
     juce::String text = textInput.getText().trim();
+    if (text == lastProcessedText)
+        return;
+    
+    lastProcessedText = text;
     
     // Always set intensity first
     float intensity = (float)intensitySlider.getValue();
@@ -151,10 +177,12 @@ void SonaraAudioProcessorEditor::processTextInput()
     if (audioProcessor.isGeminiEnabled())
     {
         // Use Gemini-enhanced processing
-        audioProcessor.processTextInputWithGemini(text, [this]() {
+        juce::Component::SafePointer<SonaraAudioProcessorEditor> safeThis(this);
+        audioProcessor.processTextInputWithGemini(text, [safeThis]() {
             // Update UI when processing completes (ensure we're on message thread)
-            juce::MessageManager::callAsync([this]() {
-                updateChangesDisplay();
+            juce::MessageManager::callAsync([safeThis]() {
+                if (safeThis != nullptr)
+                    safeThis->updateChangesDisplay();
             });
         });
     }
@@ -170,28 +198,9 @@ void SonaraAudioProcessorEditor::sliderValueChanged(juce::Slider* slider)
 {
     if (slider == &intensitySlider)
     {
-        juce::String currentText = textInput.getText();
-        if (currentText.trim().isNotEmpty())
-        {
-            float intensity = (float)intensitySlider.getValue();
-            audioProcessor.setIntensity(intensity);
-            
-            // Use Gemini if enabled, otherwise fall back to direct processing
-            if (audioProcessor.isGeminiEnabled())
-            {
-                audioProcessor.processTextInputWithGemini(currentText, [this]() {
-                    // Ensure UI update happens on message thread
-                    juce::MessageManager::callAsync([this]() {
-                        updateChangesDisplay();
-                    });
-                });
-            }
-            else
-            {
-                audioProcessor.processTextInput(currentText);
-                updateChangesDisplay();
-            }
-        }
+        // Only the scale changes, so the text already mapped is reused
+        audioProcessor.updateIntensity((float)intensitySlider.getValue());
+        updateChangesDisplay();
     }
 }
 
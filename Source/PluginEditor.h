@@ -5,7 +5,8 @@
 
 class SonaraAudioProcessorEditor : public juce::AudioProcessorEditor,
                                    public juce::TextEditor::Listener,
-                                   public juce::Slider::Listener
+                                   public juce::Slider::Listener,
+                                   private juce::Timer
 {
 public:
     SonaraAudioProcessorEditor(SonaraAudioProcessor&);
@@ -21,6 +22,16 @@ public:
 private:
     SonaraAudioProcessor& audioProcessor;
     
+    // Typing is processed once it pauses for debounceMs, or at least every
+    // maxWaitMs while it goes on; Return and focus loss process at once
+    static constexpr int debounceMs = 350;
+    static constexpr int maxWaitMs = 1500;
+    juce::uint32 firstPendingEditTime = 0;
+    bool hasPendingEdit = false;
+    
+    // Text last sent to the processor, so unchanged text is never re-mapped
+    juce::String lastProcessedText;
+    
     // UI Components
     juce::Label titleLabel;
     juce::TextEditor textInput;
@@ -46,6 +57,7 @@ private:
     
     void updateChangesDisplay();
     void processTextInput();
+    void timerCallback() override;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SonaraAudioProcessorEditor)
 };
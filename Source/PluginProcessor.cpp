@@ -1,6 +1,9 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include <cmath>
 #include <cstdlib>
+#include <limits>
+#include <type_traits>
 
 // Try to include config.h if it exists (gitignored, contains API key)
 // If config.h doesn't exist, GEMINI_API_KEY will be undefined
@@ -13,6 +16,131 @@
     #include "../../config.h"
 #endif
 
+namespace
+{
+    // Plugin state layout: magic, version, then version 1's fields; version 2
+    // appends the host parameters, version 3 adds the low mid band to the
+    // stored mapping
+    constexpr int stateMagic = 0x534e5241; // "SNRA"
+    constexpr int stateVersion = 3;
+
+    // Host parameter IDs; hosts store automation against these, so they
+    // must never change
+    namespace ParameterIDs
+    {
+        constexpr const char* highShelfFreq        = "highShelfFreq";
+        constexpr const char* highShelfGain        = "highShelfGain";
+        constexpr const char* midFreq              = "midFreq";
+        constexpr const char* midGain              = "midGain";
+        constexpr const char* midQ                 = "midQ";
+        constexpr const char* lowMidFreq           = "lowMidFreq";
+        constexpr const char* lowMidGain           = "lowMidGain";
+        constexpr const char* lowMidQ              = "lowMidQ";
+        constexpr const char* lowShelfFreq         = "lowShelfFreq";
+        constexpr const char* lowShelfGain         = "lowShelfGain";
+        constexpr const char* compressorThreshold  = "compressorThreshold";
+        constexpr const char* compressorRatio      = "compressorRatio";
+        constexpr const char* compressorAttack     = "compressorAttack";
+        constexpr const char* compressorRelease    = "compressorRelease";
+        constexpr const char* compressorMakeupGain = "compressorMakeupGain";
+        constexpr const char* compressorEnabled    = "compressorEnabled";
+        constexpr const char* reverbRoomSize       = "reverbRoomSize";
+        constexpr const char* reverbDamping        = "reverbDamping";
+        constexpr const char* reverbWidth          = "reverbWidth";
+        constexpr const char* reverbWetLevel       = "reverbWetLevel";
+        constexpr const char* reverbDryLevel       = "reverbDryLevel";
+        constexpr const char* reverbEnabled        = "reverbEnabled";
+    }
+
+    /**
+     * Calls visit with the ID and field of every host parameter that existed
+     * in version 1 of the plugin state, in the order that stores them.
+     */
+    template <typename Parameters, typename Visitor>
+    void visitVersion1Parameters(Parameters& params, Visitor&& visit)
+    {
+        visit(ParameterIDs::highShelfFreq, params.eq.highShelfFreq);
+        visit(ParameterIDs::highShelfGain, params.eq.highShelfGain);
+        visit(ParameterIDs::midFreq, params.eq.midFreq);
+        visit(ParameterIDs::midGain, params.eq.midGain);
+        visit(ParameterIDs::midQ, params.eq.midQ);
+        visit(ParameterIDs::lowShelfFreq, params.eq.lowShelfFreq);
+        visit(ParameterIDs::lowShelfGain, params.eq.lowShelfGain);
+
+        visit(ParameterIDs::compressorThreshold, params.compressor.threshold);
+        visit(ParameterIDs::compressorRatio, params.compressor.ratio);
+        visit(ParameterIDs::compressorAttack, params.compressor.attack);
+        visit(ParameterIDs::compressorRelease, params.compressor.release);
+        visit(ParameterIDs::compressorMakeupGain, params.compressor.makeupGain);
+        visit(ParameterIDs::compressorEnabled, params.compressor.enabled);
+
+        visit(ParameterIDs::reverbRoomSize, params.reverb.roomSize);
+        visit(ParameterIDs::reverbDamping, params.reverb.damping);
+        visit(ParameterIDs::reverbWidth, params.reverb.width);
+        visit(ParameterIDs::reverbWetLevel, params.reverb.wetLevel);
+        visit(ParameterIDs::reverbDryLevel, params.reverb.dryLevel);
+        visit(ParameterIDs::reverbEnabled, params.reverb.enabled);
+    }
+
+    /** The same for the host parameters added in version 3. */
+    template <typename Parameters, typename Visitor>
+    void visitVersion3Parameters(Parameters& params, Visitor&& visit)
+    {
+        visit(ParameterIDs::lowMidFreq, params.eq.lowMidFreq);
+        visit(ParameterIDs::lowMidGain, params.eq.lowMidGain);
+        visit(ParameterIDs::lowMidQ, params.eq.lowMidQ);
+    }
+
+    /**
+     * Calls visit with the ID and field of every setting that is a host
+     * parameter, in a fixed order, so the parameter list, the audio thread's
+     * reads and the mapped prompts can't disagree about which is which.
+     */
+    template <typename Parameters, typename Visitor>
+    void visitHostParameters(Parameters& params, Visitor&& visit)
+    {
+        visitVersion1Parameters(params, visit);
+        visitVersion3Parameters(params, visit);
+    }
+
+    /**
+     * Calls visit on every field of the parameters that a state of the given
+     * version stores, in the order it stores them, so saving and loading
+     * can't disagree about the layout.
+     */
+    template <typename Parameters, typename Visitor>
+    void visitParameters(Parameters& params, int version, Visitor&& visit)
+    {
+        auto visitValue = [&visit](const char*, auto& value) { visit(value); };
+
+        visitVersion1Parameters(params, visitValue);
+        visit(params.intensity);
+
+        if (version >= 3)
+            visitVersion3Parameters(params, visitValue);
+    }
+
+    template <typename Value>
+    constexpr bool isBool = std::is_same_v<std::decay_t<Value>, bool>;
+
+    // Sets a host parameter, in plain units, inside a change gesture as if
+    // the user had moved the control, so hosts in touch or latch automation
+    // record it instead of ignoring it
+    void setParameterFromCode(juce::RangedAudioParameter& parameter, float value)
+    {
+        parameter.beginChangeGesture();
+        parameter.setValueNotifyingHost(parameter.convertTo0to1(value));
+        parameter.endChangeGesture();
+    }
+
+    juce::NormalisableRange<float> makeRange(float min, float max, float interval, float centre)
+    {
+        juce::NormalisableRange<float> range(min, max, interval);
+        range.setSkewForCentre(centre);
+        return range;
+    }
+}
+
 SonaraAudioProcessor::SonaraAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
      : AudioProcessor (BusesProperties()
@@ -22,9 +150,33 @@ SonaraAudioProcessor::SonaraAudioProcessor()
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
-                       )
+                       ),
+#else
+     :
 #endif
+       parameters (*this, nullptr, "Parameters", createParameterLayout())
 {
+    const AudioParameters defaults;
+    size_t index = 0;
+    visitHostParameters(defaults, [this, &index](const char* id, const auto&)
+    {
+        rawParameterValues[index++] = parameters.getRawParameterValue(id);
+    });
+    jassert(index == numHostParameters);
+    
+    // Nothing has been handed to the chain yet; NaN differs from every value
+    appliedParameterValues.fill(std::numeric_limits<float>::quiet_NaN());
+    
+    // Keeping Gemini responses between sessions writes prompts to disk, so
+    // it only happens when asked for
+    const auto cacheFile = juce::SystemStats::getEnvironmentVariable("SONARA_GEMINI_CACHE_FILE", {}).trim();
+    if (cacheFile.isNotEmpty())
+        keywordMapper.setGeminiCacheFile(juce::File::getCurrentWorkingDirectory().getChildFile(cacheFile));
+    
+    // Lets test setups point the plugin at a local stand-in server
+    const auto endpoint = juce::SystemStats::getEnvironmentVariable("SONARA_GEMINI_ENDPOINT", {}).trim();
+    if (endpoint.isNotEmpty())
+        keywordMapper.setGeminiEndpoint(endpoint);
 
     juce::String apiKey;
     
@@ -51,6 +203,56 @@ SonaraAudioProcessor::SonaraAudioProcessor()
 
 SonaraAudioProcessor::~SonaraAudioProcessor()
 {
+    cancelPendingUpdate();
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout SonaraAudioProcessor::createParameterLayout()
+{
+    // Defaults are AudioParameters' defaults, i.e. the chain doing nothing
+    const AudioParameters defaults;
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    auto addFloat = [&layout](const char* id, const char* name, juce::NormalisableRange<float> range,
+                              float defaultValue, const juce::String& label)
+    {
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { id, 1 }, name, range, defaultValue,
+                                                               juce::AudioParameterFloatAttributes().withLabel(label)));
+    };
+    auto addBool = [&layout](const char* id, const char* name, bool defaultValue)
+    {
+        layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { id, 1 }, name, defaultValue));
+    };
+
+    const auto frequency = makeRange(20.0f, 20000.0f, 1.0f, 1000.0f);
+    const juce::NormalisableRange<float> gain(-24.0f, 24.0f, 0.1f);
+    const juce::NormalisableRange<float> unit(0.0f, 1.0f, 0.01f);
+
+    addFloat(ParameterIDs::highShelfFreq, "High Shelf Freq", frequency, defaults.eq.highShelfFreq, "Hz");
+    addFloat(ParameterIDs::highShelfGain, "High Shelf Gain", gain, defaults.eq.highShelfGain, "dB");
+    addFloat(ParameterIDs::midFreq, "Mid Freq", frequency, defaults.eq.midFreq, "Hz");
+    addFloat(ParameterIDs::midGain, "Mid Gain", gain, defaults.eq.midGain, "dB");
+    addFloat(ParameterIDs::midQ, "Mid Q", makeRange(0.1f, 10.0f, 0.01f, 1.0f), defaults.eq.midQ, {});
+    addFloat(ParameterIDs::lowMidFreq, "Low Mid Freq", frequency, defaults.eq.lowMidFreq, "Hz");
+    addFloat(ParameterIDs::lowMidGain, "Low Mid Gain", gain, defaults.eq.lowMidGain, "dB");
+    addFloat(ParameterIDs::lowMidQ, "Low Mid Q", makeRange(0.1f, 10.0f, 0.01f, 1.0f), defaults.eq.lowMidQ, {});
+    addFloat(ParameterIDs::lowShelfFreq, "Low Shelf Freq", frequency, defaults.eq.lowShelfFreq, "Hz");
+    addFloat(ParameterIDs::lowShelfGain, "Low Shelf Gain", gain, defaults.eq.lowShelfGain, "dB");
+
+    addFloat(ParameterIDs::compressorThreshold, "Comp Threshold", juce::NormalisableRange<float>(-60.0f, 0.0f, 0.1f), defaults.compressor.threshold, "dB");
+    addFloat(ParameterIDs::compressorRatio, "Comp Ratio", makeRange(1.0f, 20.0f, 0.1f, 4.0f), defaults.compressor.ratio, ":1");
+    addFloat(ParameterIDs::compressorAttack, "Comp Attack", makeRange(0.1f, 200.0f, 0.1f, 10.0f), defaults.compressor.attack, "ms");
+    addFloat(ParameterIDs::compressorRelease, "Comp Release", makeRange(10.0f, 2000.0f, 1.0f, 150.0f), defaults.compressor.release, "ms");
+    addFloat(ParameterIDs::compressorMakeupGain, "Comp Makeup", juce::NormalisableRange<float>(-12.0f, 24.0f, 0.1f), defaults.compressor.makeupGain, "dB");
+    addBool(ParameterIDs::compressorEnabled, "Comp Enabled", defaults.compressor.enabled);
+
+    addFloat(ParameterIDs::reverbRoomSize, "Reverb Size", unit, defaults.reverb.roomSize, {});
+    addFloat(ParameterIDs::reverbDamping, "Reverb Damping", unit, defaults.reverb.damping, {});
+    addFloat(ParameterIDs::reverbWidth, "Reverb Width", unit, defaults.reverb.width, {});
+    addFloat(ParameterIDs::reverbWetLevel, "Reverb Wet", unit, defaults.reverb.wetLevel, {});
+    addFloat(ParameterIDs::reverbDryLevel, "Reverb Dry", unit, defaults.reverb.dryLevel, {});
+    addBool(ParameterIDs::reverbEnabled, "Reverb Enabled", defaults.reverb.enabled);
+
+    return layout;
 }
 
 const juce::String SonaraAudioProcessor::getName() const
@@ -87,7 +289,21 @@ bool SonaraAudioProcessor::isMidiEffect() const
 
 double SonaraAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // Hosts ask from their own threads, so this works from the parameters
+    // rather than from the chain the audio thread owns
+    AudioParameters current;
+    size_t index = 0;
+    visitHostParameters(current, [this, &index](const char*, auto& value)
+    {
+        const float raw = rawParameterValues[index++]->load(std::memory_order_relaxed);
+        
+        if constexpr (isBool<decltype(value)>)
+            value = raw >= 0.5f;
+        else
+            value = raw;
+    });
+    
+    return ProcessingChain<float>::getTailLengthSeconds(current);
 }
 
 int SonaraAudioProcessor::getNumPrograms()
@@ -117,14 +333,30 @@ void SonaraAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
     currentSampleRate = sampleRate;
     
-    equalizer.setSampleRate(sampleRate);
-    compressor.setSampleRate(sampleRate);
-    reverbProcessor.setSampleRate(sampleRate);
+    const auto numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32)samplesPerBlock, (juce::uint32)numChannels };
     
-    // Reset processors
-    equalizer.reset();
-    compressor.reset();
-    reverbProcessor.reset();
+    // Give the chain the session's settings before preparing it: prepare()
+    // ends in a reset, which snaps to them instead of gliding in from flat.
+    // If a batch of parameter changes is still being written, the first
+    // block hands them over instead
+    appliedParameterValues.fill(std::numeric_limits<float>::quiet_NaN());
+    
+    AudioParameters current;
+    bool changed = false;
+    const bool haveParameters = readHostParameters(current, changed);
+    
+    auto prepareChain = [&](auto& chain)
+    {
+        if (haveParameters)
+            chain.setParameters(current);
+        chain.prepare(spec);
+    };
+    
+    if (isUsingDoublePrecision())
+        prepareChain(doubleChain);
+    else
+        prepareChain(floatChain);
 }
 
 void SonaraAudioProcessor::releaseResources()
@@ -155,7 +387,18 @@ bool SonaraAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) co
 void SonaraAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ignoreUnused(midiMessages);
-    
+    process(buffer, floatChain);
+}
+
+void SonaraAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    process(buffer, doubleChain);
+}
+
+template <typename SampleType>
+void SonaraAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, ProcessingChain<SampleType>& chain)
+{
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -163,10 +406,54 @@ void SonaraAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
     
+    // Read the host parameters at the block boundary, without locking; the
+    // chain only hears about them when one has moved (automation, a mapped
+    // prompt, a restored session), and smooths the change itself. While a
+    // prompt is half written it keeps its settings for another block
+    AudioParameters current;
+    bool changed = false;
+    if (readHostParameters(current, changed) && changed)
+        chain.setParameters(current);
+    
     // Process audio through chain
-    equalizer.processBlock(buffer);
-    compressor.processBlock(buffer);
-    reverbProcessor.processBlock(buffer);
+    chain.processBlock(buffer);
+}
+
+bool SonaraAudioProcessor::readHostParameters(AudioParameters& params, bool& changed)
+{
+    const auto batchesFinished = parameterBatchesFinished.load();
+    if (parameterBatchesInProgress.load() > 0)
+        return false;
+    
+    std::array<float, numHostParameters> raw;
+    for (size_t index = 0; index < numHostParameters; ++index)
+        raw[index] = rawParameterValues[index]->load(std::memory_order_relaxed);
+    
+    // A batch that started, or even finished, while we were reading may
+    // have left some of these old and some new
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (parameterBatchesInProgress.load() > 0 || parameterBatchesFinished.load() != batchesFinished)
+        return false;
+    
+    changed = false;
+    size_t index = 0;
+    visitHostParameters(params, [this, &raw, &changed, &index](const char*, auto& value)
+    {
+        if (raw[index] != appliedParameterValues[index])
+        {
+            appliedParameterValues[index] = raw[index];
+            changed = true;
+        }
+        
+        if constexpr (isBool<decltype(value)>)
+            value = raw[index] >= 0.5f;
+        else
+            value = raw[index];
+        
+        ++index;
+    });
+    
+    return true;
 }
 
 bool SonaraAudioProcessor::hasEditor() const
@@ -181,51 +468,170 @@ juce::AudioProcessorEditor* SonaraAudioProcessor::createEditor()
 
 void SonaraAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    // Save state
-    juce::ignoreUnused(destData);
+    // The prompt, intensity and the prompt's mapping, so a session reopens
+    // sounding the same without running the mapper or asking Gemini, then the
+    // host parameters, which may since have been tweaked or automated
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(stateMagic);
+    stream.writeInt(stateVersion);
+    
+    {
+        const juce::ScopedLock lock(mappedLock);
+        stream.writeString(currentPrompt);
+        stream.writeFloat(currentIntensity);
+        stream.writeBool(hasMapped);
+        stream.writeFloat(lastMapped.keywordIntensity);
+        
+        visitParameters(lastMapped.nominal, stateVersion, [&stream](const auto& value)
+        {
+            if constexpr (isBool<decltype(value)>)
+                stream.writeBool(value);
+            else
+                stream.writeFloat(value);
+        });
+    }
+    
+    parameters.copyState().writeToStream(stream);
 }
 
 void SonaraAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // Restore state
-    juce::ignoreUnused(data, sizeInBytes);
+    juce::MemoryInputStream stream(data, (size_t)juce::jmax(0, sizeInBytes), false);
+    
+    // Unknown data or a newer layout than this build knows: keep the current state
+    if (stream.getTotalLength() < 8 || stream.readInt() != stateMagic)
+        return;
+    
+    const int version = stream.readInt();
+    if (version < 1 || version > stateVersion)
+        return;
+    
+    const auto prompt = stream.readString();
+    
+    // Truncated state would read as zeros; better to keep what we have
+    MappedText restored;
+    size_t fixedSize = sizeof(float) + 1 + sizeof(float);
+    visitParameters(restored.nominal, version, [&fixedSize](const auto& value)
+    {
+        fixedSize += isBool<decltype(value)> ? 1 : sizeof(float);
+    });
+    
+    if (stream.getNumBytesRemaining() < (juce::int64)fixedSize)
+        return;
+    
+    const float intensity = stream.readFloat();
+    const bool mapped = stream.readBool();
+    restored.keywordIntensity = stream.readFloat();
+    
+    visitParameters(restored.nominal, version, [&stream](auto& value)
+    {
+        if constexpr (isBool<decltype(value)>)
+            value = stream.readBool();
+        else
+            value = stream.readFloat();
+    });
+    
+    if (!std::isfinite(intensity))
+        return;
+    
+    juce::ValueTree restoredParameters;
+    if (version >= 2)
+        restoredParameters = juce::ValueTree::readFromStream(stream);
+    
+    // The restored prompt replaces whatever Gemini is still working on
+    keywordMapper.cancelGeminiRequests();
+    
+    currentIntensity = intensity;
+    {
+        const juce::ScopedLock lock(mappedLock);
+        ++latestPromptRequest;
+        currentPrompt = prompt;
+        lastMapped = restored;
+        hasMapped = mapped;
+    }
+    
+    // Version 1 sessions predate host parameters: rebuild them from the mapping
+    const ScopedParameterBatch batch(*this);
+    if (restoredParameters.hasType(parameters.state.getType()))
+    {
+        parameters.replaceState(restoredParameters);
+        
+        // Version 2 sessions have no low mid band; it stays flat, as it was then
+        if (version < 3)
+            visitVersion3Parameters(restored.nominal, [this](const char* id, float value)
+            {
+                setParameterFromCode(*parameters.getParameter(id), value);
+            });
+    }
+    else
+    {
+        applyToParameters(KeywordMapper::applyIntensity(restored, intensity));
+    }
+}
+
+juce::String SonaraAudioProcessor::getPrompt() const
+{
+    const juce::ScopedLock lock(mappedLock);
+    return currentPrompt;
 }
 
 void SonaraAudioProcessor::processTextInput(const juce::String& text)
 {
-    // Process text and apply parameters
-    AudioParameters params = keywordMapper.processText(text, currentIntensity);
+    // Supersedes a Gemini request still running, e.g. when the prompt is cleared
+    keywordMapper.cancelGeminiRequests();
+    const auto mapped = keywordMapper.mapText(text);
+    {
+        const juce::ScopedLock lock(mappedLock);
+        ++latestPromptRequest;
+        currentPrompt = text;
+        lastMapped = mapped;
+        hasMapped = true;
+    }
     
-    // Reset EQ to flat response first
-    equalizer.setHighShelf(10000.0f, 0.0f);
-    equalizer.setMidPeak(2000.0f, 0.0f, 1.0f);
-    equalizer.setLowShelf(100.0f, 0.0f);
+    applyToParameters(KeywordMapper::applyIntensity(mapped, currentIntensity));
+}
+
+void SonaraAudioProcessor::setIntensity(float intensity)
+{
+    currentIntensity = intensity;
+}
+
+void SonaraAudioProcessor::updateIntensity(float intensity)
+{
+    currentIntensity = intensity;
     
-    // Apply EQ settings (always apply, even if 0, to ensure proper reset)
-    equalizer.setHighShelf(params.eq.highShelfFreq, params.eq.highShelfGain);
-    equalizer.setMidPeak(params.eq.midFreq, params.eq.midGain, params.eq.midQ);
-    equalizer.setLowShelf(params.eq.lowShelfFreq, params.eq.lowShelfGain);
+    AudioParameters params;
+    {
+        const juce::ScopedLock lock(mappedLock);
+        if (!hasMapped)
+            return;
+        
+        params = KeywordMapper::applyIntensity(lastMapped, intensity);
+    }
     
-    // Apply compressor settings
-    compressor.setThreshold(params.compressor.threshold);
-    compressor.setRatio(params.compressor.ratio);
-    compressor.setAttack(params.compressor.attack);
-    compressor.setRelease(params.compressor.release);
-    compressor.setMakeupGain(params.compressor.makeupGain);
-    compressor.setEnabled(params.compressor.enabled);
+    applyToParameters(params);
+}
+
+void SonaraAudioProcessor::applyToParameters(const AudioParameters& params)
+{
+    const ScopedParameterBatch batch(*this);
     
-    // Apply reverb settings
-    reverbProcessor.setRoomSize(params.reverb.roomSize);
-    reverbProcessor.setDamping(params.reverb.damping);
-    reverbProcessor.setWidth(params.reverb.width);
-    reverbProcessor.setWetLevel(params.reverb.wetLevel);
-    reverbProcessor.setDryLevel(params.reverb.dryLevel);
-    reverbProcessor.setEnabled(params.reverb.enabled);
+    visitHostParameters(params, [this](const char* id, const auto& value)
+    {
+        // Out-of-range values (e.g. a room size scaled past 1) are clamped here
+        setParameterFromCode(*parameters.getParameter(id), (float)value);
+    });
 }
 
-void SonaraAudioProcessor::setIntensity(float intensity)
+void SonaraAudioProcessor::handleAsyncUpdate()
 {
-    currentIntensity = intensity;
+    AudioParameters params;
+    {
+        const juce::ScopedLock lock(mappedLock);
+        params = KeywordMapper::applyIntensity(lastMapped, currentIntensity);
+    }
+    
+    applyToParameters(params);
 }
 
 std::vector<ChangeLog> SonaraAudioProcessor::getChangeLog() const
@@ -245,33 +651,29 @@ bool SonaraAudioProcessor::isGeminiEnabled() const
 
 void SonaraAudioProcessor::processTextInputWithGemini(const juce::String& text, std::function<void()> onComplete)
 {
-    keywordMapper.processTextWithGemini(text, currentIntensity, [this, onComplete](const AudioParameters& params) {
-        // Apply the parameters (same logic as processTextInput)
-        // Reset EQ to flat response first
-        equalizer.setHighShelf(10000.0f, 0.0f);
-        equalizer.setMidPeak(2000.0f, 0.0f, 1.0f);
-        equalizer.setLowShelf(100.0f, 0.0f);
-        
-        // Apply EQ settings
-        equalizer.setHighShelf(params.eq.highShelfFreq, params.eq.highShelfGain);
-        equalizer.setMidPeak(params.eq.midFreq, params.eq.midGain, params.eq.midQ);
-        equalizer.setLowShelf(params.eq.lowShelfFreq, params.eq.lowShelfGain);
-        
-        // Apply compressor settings
-        compressor.setThreshold(params.compressor.threshold);
-        compressor.setRatio(params.compressor.ratio);
-        compressor.setAttack(params.compressor.attack);
-        compressor.setRelease(params.compressor.release);
-        compressor.setMakeupGain(params.compressor.makeupGain);
-        compressor.setEnabled(params.compressor.enabled);
-        
-        // Apply reverb settings
-        reverbProcessor.setRoomSize(params.reverb.roomSize);
-        reverbProcessor.setDamping(params.reverb.damping);
-        reverbProcessor.setWidth(params.reverb.width);
-        reverbProcessor.setWetLevel(params.reverb.wetLevel);
-        reverbProcessor.setDryLevel(params.reverb.dryLevel);
-        reverbProcessor.setEnabled(params.reverb.enabled);
+    juce::int64 request;
+    {
+        const juce::ScopedLock lock(mappedLock);
+        request = ++latestPromptRequest;
+    }
+    
+    keywordMapper.processTextWithGemini(text, [this, text, onComplete, request](const MappedText& mapped) {
+        // Runs on the Gemini thread, so only record the mapping; the host
+        // parameters are set from the message thread, and it's scaled there
+        // in case the slider moves meanwhile. The prompt changes with its
+        // mapping, so a session saved while Gemini is busy keeps the old pair.
+        // An answer overtaken by another prompt, a cleared one or a restored
+        // session is dropped.
+        {
+            const juce::ScopedLock lock(mappedLock);
+            if (request != latestPromptRequest)
+                return;
+            
+            currentPrompt = text;
+            lastMapped = mapped;
+            hasMapped = true;
+        }
+        triggerAsyncUpdate();
         
         // Call completion callback if provided
         if (onComplete) {
@@ -1,14 +1,15 @@
 #pragma once
 
 #include <juce_audio_processors/juce_audio_processors.h>
-#include "AudioProcessing/Equalizer.h"
-#include "AudioProcessing/Compressor.h"
-#include "AudioProcessing/ReverbProcessor.h"
+#include "AudioProcessing/ProcessingChain.h"
 #include "KeywordMapper.h"
 #include "ChangesLogger.h"
+#include <array>
+#include <atomic>
 #include <functional>
 
-class SonaraAudioProcessor : public juce::AudioProcessor
+class SonaraAudioProcessor : public juce::AudioProcessor,
+                             private juce::AsyncUpdater
 {
 public:
     SonaraAudioProcessor();
@@ -22,6 +23,8 @@ public:
 #endif
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -45,6 +48,14 @@ public:
     // Custom parameters
     void processTextInput(const juce::String& text);
     void setIntensity(float intensity);
+    
+    // Rescales the last mapped prompt to a new intensity; neither the
+    // keyword mapper nor Gemini runs again
+    void updateIntensity(float intensity);
+    
+    // The prompt and intensity last applied, e.g. restored from a session
+    juce::String getPrompt() const;
+    float getIntensity() const { return currentIntensity; }
     std::vector<ChangeLog> getChangeLog() const;
     
     // Gemini LLM integration
@@ -52,14 +63,73 @@ public:
     bool isGeminiEnabled() const;
     void processTextInputWithGemini(const juce::String& text, std::function<void()> onComplete = nullptr);
     
+    // Every setting of the processing chain as a host parameter. Mapped
+    // prompts are written here, and processBlock reads the chain's settings
+    // back from here, so automation and prompts drive the same values
+    juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
+    
 private:
-    Equalizer equalizer;
-    Compressor compressor;
-    ReverbProcessor reverbProcessor;
+    static constexpr size_t numHostParameters = 22;
+    
+    // One chain per sample type; prepareToPlay only prepares the one the
+    // host's processing precision uses
+    ProcessingChain<float> floatChain;
+    ProcessingChain<double> doubleChain;
     KeywordMapper keywordMapper;
     
+    juce::AudioProcessorValueTreeState parameters;
+    
+    // Read lock-free by processBlock; the chain is only updated when one of
+    // them differs from what it was last given. Audio thread only, apart
+    // from prepareToPlay
+    std::array<std::atomic<float>*, numHostParameters> rawParameterValues {};
+    std::array<float, numHostParameters> appliedParameterValues {};
+    
+    // A prompt or a restored session sets the host parameters one by one;
+    // these let processBlock tell a complete set from one half written
+    std::atomic<int> parameterBatchesInProgress { 0 };
+    std::atomic<juce::uint32> parameterBatchesFinished { 0 };
+    
+    // Marks the parameter changes made during its lifetime as one batch
+    struct ScopedParameterBatch
+    {
+        explicit ScopedParameterBatch(SonaraAudioProcessor& p) : processor(p) { ++processor.parameterBatchesInProgress; }
+        ~ScopedParameterBatch() { ++processor.parameterBatchesFinished; --processor.parameterBatchesInProgress; }
+        
+        SonaraAudioProcessor& processor;
+    };
+    
     double currentSampleRate = 44100.0;
-    float currentIntensity = 1.0f;
+    std::atomic<float> currentIntensity { 1.0f };
+    
+    // The last prompt and its mapping before intensity, set from the message
+    // thread or the Gemini thread; this is what the plugin state stores
+    juce::CriticalSection mappedLock;
+    juce::String currentPrompt;
+    MappedText lastMapped;
+    bool hasMapped = false;
+    
+    // Numbers each prompt change; a Gemini answer for an older one is dropped
+    juce::int64 latestPromptRequest = 0;
+    
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    
+    /** Both processBlock overloads: reads the host parameters and runs the chain. */
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, ProcessingChain<SampleType>& chain);
+    
+    /**
+     * Reads every host parameter into params and notes whether any moved
+     * since the last read. Returns false, touching nothing, while a batch
+     * of parameter changes is being written.
+     */
+    bool readHostParameters(AudioParameters& params, bool& changed);
+    
+    // Message thread only: sets the host parameters to a mapped prompt
+    void applyToParameters(const AudioParameters& params);
+    
+    // Applies a mapping that finished on the Gemini thread
+    void handleAsyncUpdate() override;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SonaraAudioProcessor)
 };
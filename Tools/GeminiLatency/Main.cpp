@@ -0,0 +1,303 @@
+#include "../../Source/KeywordMapper.h"
+#include "../../Source/GeminiClient.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Measures prompt-to-parameters latency through KeywordMapper::processTextWithGemini
+// (or GeminiClient's request pool or batch API), normally against
+// Tools/MockGemini so runs are repeatable and offline
+
+namespace
+{
+    const char* const usage =
+        "sonara-gemini-latency [--endpoint=<url>] [--api-key=<key>] [--requests=200] [--concurrency=1]\n"
+        "                      [--prompts=<file>] [--repeat-prompts] [--timeout=30000] [--pooled | --batched=50]\n"
+        "\n"
+        "Sends prompts through KeywordMapper's Gemini path and reports latency percentiles.\n"
+        "  --endpoint        generateContent URL (default: a local sonara-mock-gemini)\n"
+        "  --api-key         key sent with each request\n"
+        "  --requests        total prompts to send\n"
+        "  --concurrency     prompts in flight at once, each from its own KeywordMapper\n"
+        "  --prompts         text file with one prompt per line\n"
+        "  --repeat-prompts  send the prompts as they are, so repeats hit the response cache;\n"
+        "                    by default each prompt is made unique\n"
+        "  --timeout         milliseconds to wait for each answer\n"
+        "  --pooled          queue everything on one GeminiClient with --concurrency requests in flight,\n"
+        "                    and break the time down into queueing, connecting and transfer\n"
+        "  --batched         send everything through GeminiClient::processTextsSync, this many prompts per request";
+
+    const char* const defaultEndpoint = "http://127.0.0.1:8765/v1beta/models/mock:generateContent";
+
+    const char* const defaultPrompts[] = {
+        "make it brighter",
+        "warmer with more body",
+        "add a little hall reverb",
+        "more punch and glue the mix",
+        "deeper bass, less boomy",
+        "remove the reverb and make it dry",
+        "vocals should cut through",
+        "super airy and spacious",
+    };
+
+    struct Sample
+    {
+        double milliseconds = 0.0;
+        bool answered = false;
+        bool usedGemini = false;
+        GeminiClient::RequestTiming timing;
+    };
+
+    juce::StringArray getPrompts(const juce::ArgumentList& args)
+    {
+        juce::StringArray prompts;
+
+        if (args.containsOption("--prompts"))
+        {
+            auto file = args.getExistingFileForOption("--prompts");
+            file.readLines(prompts);
+            prompts.trim();
+            prompts.removeEmptyStrings();
+        }
+        else
+        {
+            for (auto* prompt : defaultPrompts)
+                prompts.add(prompt);
+        }
+
+        if (prompts.isEmpty())
+            juce::ConsoleApplication::fail("No prompts to send");
+
+        return prompts;
+    }
+
+    double getPercentile(const std::vector<double>& sorted, double percentile)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        const auto index = (size_t)std::ceil(percentile / 100.0 * (double)sorted.size());
+        return sorted[juce::jlimit((size_t)0, sorted.size() - 1, index > 0 ? index - 1 : 0)];
+    }
+
+    juce::String getPrompt(const juce::StringArray& prompts, int index, bool repeatPrompts)
+    {
+        auto prompt = prompts[index % prompts.size()];
+        if (!repeatPrompts)
+            prompt << " #" << index;
+        return prompt;
+    }
+
+    void sendThroughMappers(std::vector<Sample>& samples, const juce::StringArray& prompts, bool repeatPrompts,
+                            const juce::String& endpoint, const juce::String& apiKey, int concurrency, int timeoutMs)
+    {
+        const int numRequests = (int)samples.size();
+        std::atomic<int> nextRequest { 0 };
+
+        // Each worker drives its own mapper, and so its own GeminiClient,
+        // because a client only keeps the newest of its requests
+        auto worker = [&]
+        {
+            KeywordMapper mapper;
+            mapper.setGeminiEndpoint(endpoint);
+            mapper.setGeminiApiKey(apiKey);
+
+            for (int index = nextRequest++; index < numRequests; index = nextRequest++)
+            {
+                const auto prompt = getPrompt(prompts, index, repeatPrompts);
+
+                // Shared, since a timed-out answer may still arrive after we've moved on
+                auto answered = std::make_shared<juce::WaitableEvent>();
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                mapper.processTextWithGemini(prompt, [answered](const MappedText&)
+                {
+                    answered->signal();
+                });
+
+                auto& sample = samples[(size_t)index];
+                sample.answered = answered->wait(timeoutMs);
+                sample.milliseconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0;
+
+                if (sample.answered)
+                {
+                    const auto changes = mapper.getRecentChanges();
+                    sample.usedGemini = !changes.empty() && changes.front().description.startsWith("Gemini: ");
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int i = 0; i < concurrency; ++i)
+            workers.emplace_back(worker);
+        for (auto& thread : workers)
+            thread.join();
+    }
+
+    void sendPooled(std::vector<Sample>& samples, const juce::StringArray& prompts, bool repeatPrompts,
+                    const juce::String& endpoint, const juce::String& apiKey, int concurrency, int timeoutMs)
+    {
+        juce::CriticalSection samplesLock;
+        juce::WaitableEvent allAnswered;
+        int remaining = (int)samples.size();
+
+        // Declared after what its callbacks use, so it is destroyed (and
+        // its in-flight requests aborted) first
+        GeminiClient client;
+        client.setEndpoint(endpoint);
+        client.setApiKey(apiKey);
+        client.setMaxConcurrentRequests(concurrency);
+
+        for (int index = 0; index < (int)samples.size(); ++index)
+        {
+            client.enqueueTextAsync(getPrompt(prompts, index, repeatPrompts),
+                                    [&, index](bool success, const juce::String&, const juce::String&, const GeminiClient::RequestTiming& timing)
+            {
+                const juce::ScopedLock lock(samplesLock);
+                auto& sample = samples[(size_t)index];
+                sample.answered = true;
+                sample.usedGemini = success;
+                sample.milliseconds = timing.totalMs;
+                sample.timing = timing;
+
+                if (--remaining == 0)
+                    allAnswered.signal();
+            });
+        }
+
+        // Requests go out concurrency at a time, each wave allowed timeoutMs
+        const int waves = ((int)samples.size() + concurrency - 1) / concurrency;
+        allAnswered.wait(timeoutMs * waves);
+    }
+
+    // Batched requests answer many prompts at once, so every prompt in a
+    // request shares that request's latency
+    void sendBatched(std::vector<Sample>& samples, const juce::StringArray& prompts, bool repeatPrompts,
+                     const juce::String& endpoint, const juce::String& apiKey, int promptsPerRequest)
+    {
+        GeminiClient client;
+        client.setEndpoint(endpoint);
+        client.setApiKey(apiKey);
+
+        for (int first = 0; first < (int)samples.size(); first += promptsPerRequest)
+        {
+            const int count = juce::jmin(promptsPerRequest, (int)samples.size() - first);
+
+            juce::StringArray group, processedTexts;
+            for (int i = 0; i < count; ++i)
+                group.add(getPrompt(prompts, first + i, repeatPrompts));
+
+            juce::Array<bool> succeeded;
+            const auto start = juce::Time::getHighResolutionTicks();
+            client.processTextsSync(group, processedTexts, succeeded, promptsPerRequest);
+            const double milliseconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start) * 1000.0;
+
+            for (int i = 0; i < count; ++i)
+            {
+                auto& sample = samples[(size_t)(first + i)];
+                sample.answered = true;
+                sample.usedGemini = succeeded[i];
+                sample.milliseconds = milliseconds;
+            }
+        }
+    }
+
+    void printReport(const std::vector<Sample>& samples, double seconds, bool showBreakdown)
+    {
+        std::vector<double> latencies;
+        int timedOut = 0, fellBack = 0;
+        for (const auto& sample : samples)
+        {
+            if (!sample.answered)
+            {
+                ++timedOut;
+                continue;
+            }
+
+            latencies.push_back(sample.milliseconds);
+            if (!sample.usedGemini)
+                ++fellBack;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        double total = 0.0;
+        for (auto latency : latencies)
+            total += latency;
+
+        std::cout << juce::String::formatted("answered   %d (%d without a Gemini answer, %d timed out)\n",
+                                             (int)latencies.size(), fellBack, timedOut)
+                  << juce::String::formatted("latency ms mean %.1f  p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n",
+                                             latencies.empty() ? 0.0 : total / (double)latencies.size(),
+                                             getPercentile(latencies, 50.0), getPercentile(latencies, 90.0),
+                                             getPercentile(latencies, 99.0), latencies.empty() ? 0.0 : latencies.back())
+                  << juce::String::formatted("throughput %.1f prompts/s over %.2f s\n",
+                                             (double)latencies.size() / seconds, seconds);
+
+        if (!showBreakdown || latencies.empty())
+            return;
+
+        double queued = 0.0, connect = 0.0, transfer = 0.0;
+        int fromNetwork = 0, reused = 0;
+        for (const auto& sample : samples)
+        {
+            if (!sample.answered || sample.timing.fromCache)
+                continue;
+
+            queued += sample.timing.queuedMs;
+            connect += sample.timing.connectMs;
+            transfer += sample.timing.transferMs;
+            ++fromNetwork;
+
+            if (sample.timing.reusedConnection)
+                ++reused;
+        }
+
+        const double count = (double)juce::jmax(1, fromNetwork);
+        std::cout << juce::String::formatted("mean ms    queued %.1f  connect %.1f  transfer %.1f  (%d cache hits)\n",
+                                             queued / count, connect / count, transfer / count,
+                                             (int)latencies.size() - fromNetwork)
+                  << juce::String::formatted("reused     %d of %d connections\n", reused, fromNetwork);
+    }
+
+    void runHarness(const juce::ArgumentList& args)
+    {
+        const auto endpoint = args.containsOption("--endpoint") ? args.getValueForOption("--endpoint") : juce::String(defaultEndpoint);
+        const auto apiKey = args.containsOption("--api-key") ? args.getValueForOption("--api-key") : juce::String("mock");
+        const int numRequests = args.containsOption("--requests") ? juce::jmax(1, args.getValueForOption("--requests").getIntValue()) : 200;
+        const int concurrency = args.containsOption("--concurrency") ? juce::jlimit(1, 256, args.getValueForOption("--concurrency").getIntValue()) : 1;
+        const int timeoutMs = args.containsOption("--timeout") ? juce::jmax(1, args.getValueForOption("--timeout").getIntValue()) : 30000;
+        const bool repeatPrompts = args.containsOption("--repeat-prompts");
+        const auto prompts = getPrompts(args);
+
+        std::cout << "Sending " << numRequests << " prompts to " << endpoint
+                  << " with " << concurrency << " in flight" << std::endl;
+
+        std::vector<Sample> samples((size_t)numRequests);
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        if (args.containsOption("--batched"))
+            sendBatched(samples, prompts, repeatPrompts, endpoint, apiKey, juce::jmax(1, args.getValueForOption("--batched").getIntValue()));
+        else if (args.containsOption("--pooled"))
+            sendPooled(samples, prompts, repeatPrompts, endpoint, apiKey, concurrency, timeoutMs);
+        else
+            sendThroughMappers(samples, prompts, repeatPrompts, endpoint, apiKey, concurrency, timeoutMs);
+
+        const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        printReport(samples, seconds, args.containsOption("--pooled"));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", usage, false);
+    app.addDefaultCommand({ "", "[options]", "Measure Gemini round-trip latency", "",
+                            [](const juce::ArgumentList& args) { runHarness(args); } });
+
+    return app.findAndRunCommand(argc, argv);
+}
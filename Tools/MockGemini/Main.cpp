@@ -0,0 +1,339 @@
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// Stand-in for Gemini's generateContent endpoint, for tests and machines
+// without internet access. Point the plugin at it with
+// SONARA_GEMINI_ENDPOINT=http://127.0.0.1:8765/v1beta/models/mock:generateContent
+
+namespace
+{
+    const char* const usage =
+        "sonara-mock-gemini [--port=8765] [--latency=200] [--jitter=0] [--error-rate=0] [--error-status=500]\n"
+        "                   [--invalid-rate=0] [--response=\"<text>\"] [--seed=1] [--verbose]\n"
+        "\n"
+        "Serves POST .../<model>:generateContent on 127.0.0.1 with Gemini-shaped JSON.\n"
+        "  --latency       milliseconds before each response\n"
+        "  --jitter        extra random delay, 0 to this many milliseconds\n"
+        "  --error-rate    fraction of requests answered with an error object\n"
+        "  --error-status  HTTP status used for those errors (429, 500, 503...)\n"
+        "  --invalid-rate  fraction of requests (or of prompts in a batched request) answered with [INVALID]\n"
+        "  --response      fixed text for every answer; by default the user's request is echoed back\n"
+        "  --verbose       log every request";
+
+    struct ServerOptions
+    {
+        int port = 8765;
+        int latencyMs = 200;
+        int jitterMs = 0;
+        double errorRate = 0.0;
+        int errorStatus = 500;
+        double invalidRate = 0.0;
+        juce::String fixedResponse;
+        bool verbose = false;
+    };
+
+    struct HttpRequest
+    {
+        juce::String method;
+        juce::String path;
+        juce::String body;
+        bool keepAlive = true;
+    };
+
+    struct HttpResponse
+    {
+        int status = 200;
+        juce::String body;
+    };
+
+    const char* getStatusText(int status)
+    {
+        switch (status)
+        {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 429: return "Too Many Requests";
+            case 503: return "Service Unavailable";
+            default:  return "Internal Server Error";
+        }
+    }
+
+    const char* getErrorStatusName(int status)
+    {
+        switch (status)
+        {
+            case 400: return "INVALID_ARGUMENT";
+            case 429: return "RESOURCE_EXHAUSTED";
+            case 503: return "UNAVAILABLE";
+            default:  return "INTERNAL";
+        }
+    }
+
+    class MockServer
+    {
+    public:
+        explicit MockServer(const ServerOptions& o) : options(o), random(1) {}
+
+        void setSeed(juce::int64 seed) { random.setSeed(seed); }
+
+        bool start()
+        {
+            return listener.createListener(options.port, "127.0.0.1");
+        }
+
+        // Accepts connections forever; each one is served on its own thread
+        // so concurrent clients see the configured latency in parallel
+        void run()
+        {
+            for (;;)
+            {
+                std::unique_ptr<juce::StreamingSocket> connection(listener.waitForNextConnection());
+                if (connection == nullptr)
+                    continue;
+
+                std::thread([this, socket = std::move(connection)]() mutable { serve(*socket); }).detach();
+            }
+        }
+
+    private:
+        ServerOptions options;
+        juce::StreamingSocket listener;
+        std::mutex randomLock;
+        juce::Random random;
+        std::atomic<int> requestCount { 0 };
+
+        double nextRandom()
+        {
+            std::lock_guard<std::mutex> lock(randomLock);
+            return random.nextDouble();
+        }
+
+        // HTTP/1.1 connections stay open for further requests until the
+        // client closes them or asks for Connection: close
+        void serve(juce::StreamingSocket& socket)
+        {
+            std::string pending;
+            HttpRequest request;
+
+            while (readRequest(socket, pending, request))
+            {
+                const auto response = respond(request);
+                if (!writeResponse(socket, response, request.keepAlive) || !request.keepAlive)
+                    break;
+            }
+
+            socket.close();
+        }
+
+        static bool readMore(juce::StreamingSocket& socket, std::string& pending)
+        {
+            if (socket.waitUntilReady(true, 60000) != 1)
+                return false;
+
+            char buffer[4096];
+            const int bytesRead = socket.read(buffer, (int)sizeof(buffer), false);
+            if (bytesRead <= 0)
+                return false;
+
+            pending.append(buffer, (size_t)bytesRead);
+            return true;
+        }
+
+        static bool readRequest(juce::StreamingSocket& socket, std::string& pending, HttpRequest& request)
+        {
+            size_t headerEnd;
+            while ((headerEnd = pending.find("\r\n\r\n")) == std::string::npos)
+                if (!readMore(socket, pending))
+                    return false;
+
+            auto lines = juce::StringArray::fromLines(juce::String(pending.substr(0, headerEnd)));
+            auto requestLine = juce::StringArray::fromTokens(lines[0], " ", "");
+            request.method = requestLine[0];
+            request.path = requestLine[1];
+            request.keepAlive = requestLine[2] != "HTTP/1.0";
+
+            size_t contentLength = 0;
+            for (int i = 1; i < lines.size(); ++i)
+            {
+                auto name = lines[i].upToFirstOccurrenceOf(":", false, false).trim().toLowerCase();
+                auto value = lines[i].fromFirstOccurrenceOf(":", false, false).trim();
+
+                if (name == "content-length")
+                    contentLength = (size_t)value.getLargeIntValue();
+                else if (name == "connection")
+                    request.keepAlive = value.equalsIgnoreCase("keep-alive") || (request.keepAlive && !value.equalsIgnoreCase("close"));
+            }
+
+            const size_t bodyStart = headerEnd + 4;
+            while (pending.size() < bodyStart + contentLength)
+                if (!readMore(socket, pending))
+                    return false;
+
+            request.body = juce::String::fromUTF8(pending.data() + bodyStart, (int)contentLength);
+            pending.erase(0, bodyStart + contentLength);
+            return true;
+        }
+
+        static bool writeResponse(juce::StreamingSocket& socket, const HttpResponse& response, bool keepAlive)
+        {
+            const auto body = response.body.toStdString();
+
+            juce::String head;
+            head << "HTTP/1.1 " << response.status << " " << getStatusText(response.status) << "\r\n"
+                 << "Content-Type: application/json; charset=UTF-8\r\n"
+                 << "Content-Length: " << (int)body.size() << "\r\n"
+                 << "Connection: " << (keepAlive ? "keep-alive" : "close") << "\r\n\r\n";
+
+            const auto message = head.toStdString() + body;
+            return socket.write(message.data(), (int)message.size()) == (int)message.size();
+        }
+
+        HttpResponse respond(const HttpRequest& request)
+        {
+            const int number = ++requestCount;
+
+            if (request.method == "GET" && request.path == "/health")
+                return { 200, "{\"status\":\"ok\"}" };
+
+            if (request.method != "POST" || !request.path.contains(":generateContent"))
+                return makeError(404, "Unknown endpoint " + request.path);
+
+            auto json = juce::JSON::parse(request.body);
+            auto prompt = json["contents"][0]["parts"][0]["text"].toString();
+            if (prompt.isEmpty())
+                return makeError(400, "Request has no contents[0].parts[0].text");
+
+            const int delayMs = options.latencyMs + (options.jitterMs > 0 ? (int)(nextRandom() * options.jitterMs) : 0);
+            if (delayMs > 0)
+                juce::Thread::sleep(delayMs);
+
+            HttpResponse response;
+
+            if (nextRandom() < options.errorRate)
+                response = makeError(options.errorStatus, "Mock error");
+            else if (prompt.contains(batchMarker))
+                response = makeAnswer(answerBatch(prompt));
+            else
+                response = makeAnswer(answerRequest(extractUserRequest(prompt)));
+
+            if (options.verbose)
+                std::cout << "#" << number << " " << response.status << " after " << delayMs << " ms" << std::endl;
+
+            return response;
+        }
+
+        juce::String answerRequest(const juce::String& userRequest)
+        {
+            if (nextRandom() < options.invalidRate)
+                return "[INVALID]";
+
+            return options.fixedResponse.isNotEmpty() ? options.fixedResponse : userRequest.toLowerCase();
+        }
+
+        // GeminiClient::buildBatchPrompt lists the requests as a JSON array
+        // on one line, and expects a JSON array of answers back
+        static constexpr const char* batchMarker = "User's requests, as a JSON array: ";
+
+        juce::String answerBatch(const juce::String& prompt)
+        {
+            auto requests = juce::JSON::parse(prompt.fromFirstOccurrenceOf(batchMarker, false, false)
+                                                    .upToFirstOccurrenceOf("\n", false, false));
+
+            juce::Array<juce::var> answers;
+            if (auto* list = requests.getArray())
+                for (const auto& request : *list)
+                    answers.add(answerRequest(request.toString()));
+
+            return juce::JSON::toString(juce::var(answers), true);
+        }
+
+        // GeminiClient::buildPrompt wraps the user's text as
+        //   User's request: "<text>"
+        static juce::String extractUserRequest(const juce::String& prompt)
+        {
+            const juce::String marker = "User's request: \"";
+            if (!prompt.contains(marker))
+                return prompt;
+
+            auto rest = prompt.fromFirstOccurrenceOf(marker, false, false);
+            return rest.upToFirstOccurrenceOf("\"\n", false, false);
+        }
+
+        static HttpResponse makeAnswer(const juce::String& text)
+        {
+            auto part = new juce::DynamicObject();
+            part->setProperty("text", text);
+
+            auto content = new juce::DynamicObject();
+            content->setProperty("parts", juce::Array<juce::var> { juce::var(part) });
+            content->setProperty("role", "model");
+
+            auto candidate = new juce::DynamicObject();
+            candidate->setProperty("content", juce::var(content));
+            candidate->setProperty("finishReason", "STOP");
+            candidate->setProperty("index", 0);
+
+            auto root = new juce::DynamicObject();
+            root->setProperty("candidates", juce::Array<juce::var> { juce::var(candidate) });
+
+            return { 200, juce::JSON::toString(juce::var(root), true) };
+        }
+
+        static HttpResponse makeError(int status, const juce::String& message)
+        {
+            auto error = new juce::DynamicObject();
+            error->setProperty("code", status);
+            error->setProperty("message", message);
+            error->setProperty("status", getErrorStatusName(status));
+
+            auto root = new juce::DynamicObject();
+            root->setProperty("error", juce::var(error));
+
+            return { status, juce::JSON::toString(juce::var(root), true) };
+        }
+    };
+
+    void runServer(const juce::ArgumentList& args)
+    {
+        ServerOptions options;
+        if (args.containsOption("--port"))
+            options.port = args.getValueForOption("--port").getIntValue();
+        if (args.containsOption("--latency"))
+            options.latencyMs = juce::jmax(0, args.getValueForOption("--latency").getIntValue());
+        if (args.containsOption("--jitter"))
+            options.jitterMs = juce::jmax(0, args.getValueForOption("--jitter").getIntValue());
+        if (args.containsOption("--error-rate"))
+            options.errorRate = juce::jlimit(0.0, 1.0, args.getValueForOption("--error-rate").getDoubleValue());
+        if (args.containsOption("--error-status"))
+            options.errorStatus = args.getValueForOption("--error-status").getIntValue();
+        if (args.containsOption("--invalid-rate"))
+            options.invalidRate = juce::jlimit(0.0, 1.0, args.getValueForOption("--invalid-rate").getDoubleValue());
+        options.fixedResponse = args.getValueForOption("--response");
+        options.verbose = args.containsOption("--verbose");
+
+        MockServer server(options);
+        if (args.containsOption("--seed"))
+            server.setSeed(args.getValueForOption("--seed").getLargeIntValue());
+
+        if (!server.start())
+            juce::ConsoleApplication::fail("Can't listen on port " + juce::String(options.port));
+
+        std::cout << "Mock Gemini listening on http://127.0.0.1:" << options.port
+                  << "/v1beta/models/mock:generateContent" << std::endl;
+        server.run();
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", usage, false);
+    app.addDefaultCommand({ "", "[options]", "Run the mock server", "",
+                            [](const juce::ArgumentList& args) { runServer(args); } });
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,63 @@
+#include "BatchRenderer.h"
+#include <numeric>
+
+namespace
+{
+    int resolveThreadCount(int requested)
+    {
+        return requested > 0 ? requested : juce::jmax(1, juce::SystemStats::getNumCpus());
+    }
+}
+
+BatchRenderer::BatchRenderer(const RenderSettings& settings, int numThreads)
+    : pool(resolveThreadCount(numThreads))
+{
+    for (int i = 0; i < pool.getNumWorkers(); ++i)
+        renderers.push_back(std::make_unique<OfflineRenderer>(settings));
+}
+
+std::vector<BatchResult> BatchRenderer::render(const std::vector<RenderJob>& jobs,
+                                               std::function<void(const BatchResult&)> onJobFinished)
+{
+    std::vector<BatchResult> results(jobs.size());
+    
+    // Hand jobs to the pool largest file first so long renders start early
+    // and short ones fill in the gaps at the end
+    std::vector<size_t> order(jobs.size());
+    std::iota(order.begin(), order.end(), (size_t)0);
+    
+    std::vector<juce::int64> sizes;
+    sizes.reserve(jobs.size());
+    for (const auto& job : jobs)
+        sizes.push_back(job.input.getSize());
+    
+    std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+    
+    std::vector<WorkStealingPool::Task> tasks;
+    tasks.reserve(jobs.size());
+    
+    for (auto jobIndex : order)
+    {
+        tasks.push_back([this, &jobs, &results, &onJobFinished, jobIndex](int workerIndex)
+        {
+            auto& renderer = *renderers[(size_t)workerIndex];
+            auto& result = results[jobIndex];
+            result.job = jobs[jobIndex];
+            
+            const double startMs = juce::Time::getMillisecondCounterHiRes();
+            result.success = renderer.render(result.job);
+            result.renderSeconds = (juce::Time::getMillisecondCounterHiRes() - startMs) * 0.001;
+            result.audioSeconds = renderer.getLastRenderedSeconds();
+            result.error = renderer.getLastError();
+            
+            if (onJobFinished)
+            {
+                std::lock_guard<std::mutex> lock(callbackLock);
+                onJobFinished(result);
+            }
+        });
+    }
+    
+    pool.run(tasks);
+    return results;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "OfflineRenderer.h"
+#include "WorkStealingPool.h"
+
+/**
+ * Outcome of one job in a batch.
+ */
+struct BatchResult
+{
+    RenderJob job;
+    bool success = false;
+    juce::String error;
+    double audioSeconds = 0.0;
+    double renderSeconds = 0.0;
+};
+
+/**
+ * Renders many jobs across all cores. Every worker owns its own
+ * OfflineRenderer, so no processing chain or keyword mapper is ever
+ * shared between threads.
+ */
+class BatchRenderer
+{
+public:
+    /** numThreads <= 0 uses one worker per CPU core. */
+    BatchRenderer(const RenderSettings& settings, int numThreads);
+    
+    /**
+     * Render all jobs and return their results in the original order.
+     * onJobFinished, if set, is called from the worker threads but never
+     * concurrently.
+     */
+    std::vector<BatchResult> render(const std::vector<RenderJob>& jobs,
+                                    std::function<void(const BatchResult&)> onJobFinished = nullptr);
+    
+    int getNumThreads() const { return pool.getNumWorkers(); }
+    
+private:
+    WorkStealingPool pool;
+    std::vector<std::unique_ptr<OfflineRenderer>> renderers;
+    std::mutex callbackLock;
+};
@@ -0,0 +1,248 @@
+#include "OfflineRenderer.h"
+#include "BatchRenderer.h"
+#include <iostream>
+#include <set>
+
+namespace
+{
+    const char* const usage =
+        "sonara-render --prompt=\"<text>\" [--intensity=1.0] [--block-size=4096] [--tail=0] <input> <output>\n"
+        "\n"
+        "Applies a Sonara prompt to a WAV or AIFF file and writes the result.\n"
+        "  --prompt      text to map, same as typing it into the plugin\n"
+        "  --intensity   intensity slider value (0 to 2)\n"
+        "  --block-size  samples processed per block\n"
+        "  --tail        seconds of silence rendered after the input for reverb tails,\n"
+        "                or auto to render until the tail has decayed\n"
+        "\n"
+        "sonara-render --batch --output-dir=<dir> [--input-dir=<dir>] [--prompt=\"<text>\" | --prompts=<file>] [--threads=0] [--gemini] [files...]\n"
+        "\n"
+        "Renders every input file with every prompt across all CPU cores.\n"
+        "  --input-dir   render every WAV/AIFF file in this folder (plus any files listed)\n"
+        "  --output-dir  where results go; <name>.wav, or <name>_<prompt number>.wav for several prompts;\n"
+        "                inputs sharing a name get _2, _3, ... appended; no output may overwrite an input\n"
+        "  --prompts     text file with one prompt per line\n"
+        "  --threads     worker count, 0 for one per core\n"
+        "  --gemini      rewrite the prompts with Gemini first, in batched requests (needs GEMINI_API_KEY)";
+    
+    juce::StringArray getPositionalArguments(const juce::ArgumentList& args)
+    {
+        juce::StringArray positional;
+        for (const auto& argument : args.arguments)
+            if (!argument.isOption())
+                positional.add(argument.text);
+        return positional;
+    }
+    
+    RenderSettings getRenderSettings(const juce::ArgumentList& args)
+    {
+        RenderSettings settings;
+        if (args.containsOption("--block-size"))
+            settings.blockSize = juce::jlimit(32, 1 << 20, args.getValueForOption("--block-size").getIntValue());
+        if (args.containsOption("--tail"))
+        {
+            const auto tail = args.getValueForOption("--tail");
+            settings.automaticTail = tail == "auto";
+            settings.tailSeconds = juce::jmax(0.0, tail.getDoubleValue());
+        }
+        return settings;
+    }
+    
+    void renderFile(const juce::ArgumentList& args)
+    {
+        auto files = getPositionalArguments(args);
+        if (files.size() != 2)
+            juce::ConsoleApplication::fail(usage);
+        
+        const auto settings = getRenderSettings(args);
+        
+        RenderJob job;
+        job.input = juce::File::getCurrentWorkingDirectory().getChildFile(files[0]);
+        job.output = juce::File::getCurrentWorkingDirectory().getChildFile(files[1]);
+        if (!job.input.existsAsFile())
+            juce::ConsoleApplication::fail("No such file: " + job.input.getFullPathName());
+        job.prompt = args.getValueForOption("--prompt");
+        if (args.containsOption("--intensity"))
+            job.intensity = args.getValueForOption("--intensity").getFloatValue();
+        
+        OfflineRenderer renderer(settings);
+        
+        const double startMs = juce::Time::getMillisecondCounterHiRes();
+        if (!renderer.render(job))
+            juce::ConsoleApplication::fail(renderer.getLastError());
+        const double elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startMs) * 0.001;
+        
+        std::cout << job.output.getFileName() << ": " << juce::String(renderer.getLastRenderedSeconds(), 2) << " s of audio in "
+                  << juce::String(elapsedSeconds, 2) << " s ("
+                  << juce::String(renderer.getLastRenderedSeconds() / juce::jmax(elapsedSeconds, 1.0e-6), 1) << "x real time)" << std::endl;
+    }
+    
+    juce::StringArray getBatchPrompts(const juce::ArgumentList& args)
+    {
+        juce::StringArray prompts;
+        
+        if (args.containsOption("--prompts"))
+        {
+            auto promptFile = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--prompts"));
+            if (!promptFile.existsAsFile())
+                juce::ConsoleApplication::fail("No such file: " + promptFile.getFullPathName());
+            
+            promptFile.readLines(prompts);
+            prompts.trim();
+            prompts.removeEmptyStrings();
+        }
+        
+        if (args.containsOption("--prompt"))
+            prompts.add(args.getValueForOption("--prompt"));
+        
+        if (prompts.isEmpty())
+            juce::ConsoleApplication::fail("Batch mode needs --prompt or --prompts");
+        
+        return prompts;
+    }
+    
+    juce::Array<juce::File> getBatchInputs(const juce::ArgumentList& args)
+    {
+        juce::Array<juce::File> inputs;
+        
+        if (args.containsOption("--input-dir"))
+        {
+            auto inputDir = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--input-dir"));
+            if (!inputDir.isDirectory())
+                juce::ConsoleApplication::fail("No such folder: " + inputDir.getFullPathName());
+            
+            inputs = inputDir.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff");
+            inputs.sort();
+        }
+        
+        // A file named twice, or both by name and through --input-dir, is
+        // rendered once
+        for (const auto& name : getPositionalArguments(args))
+            inputs.addIfNotAlreadyThere(juce::File::getCurrentWorkingDirectory().getChildFile(name));
+        
+        if (inputs.isEmpty())
+            juce::ConsoleApplication::fail("Batch mode found no input files");
+        
+        return inputs;
+    }
+    
+    // Configured like the plugin: GEMINI_API_KEY, plus SONARA_GEMINI_ENDPOINT
+    // for a stand-in server and SONARA_GEMINI_CACHE_FILE for a persistent
+    // response cache
+    juce::StringArray prepareWithGemini(const juce::StringArray& prompts)
+    {
+        const auto apiKey = juce::SystemStats::getEnvironmentVariable("GEMINI_API_KEY", {}).trim();
+        if (apiKey.isEmpty())
+            juce::ConsoleApplication::fail("--gemini needs GEMINI_API_KEY to be set");
+        
+        KeywordMapper mapper;
+        mapper.setGeminiEndpoint(juce::SystemStats::getEnvironmentVariable("SONARA_GEMINI_ENDPOINT", {}).trim());
+        const auto cacheFile = juce::SystemStats::getEnvironmentVariable("SONARA_GEMINI_CACHE_FILE", {}).trim();
+        if (cacheFile.isNotEmpty())
+            mapper.setGeminiCacheFile(juce::File::getCurrentWorkingDirectory().getChildFile(cacheFile));
+        mapper.setGeminiApiKey(apiKey);
+        
+        const double startMs = juce::Time::getMillisecondCounterHiRes();
+        auto prepared = mapper.prepareTextsWithGemini(prompts);
+        std::cout << "Gemini prepared " << prompts.size() << " prompts in "
+                  << juce::String((juce::Time::getMillisecondCounterHiRes() - startMs) * 0.001, 2) << " s" << std::endl;
+        
+        return prepared;
+    }
+    
+    void renderBatch(const juce::ArgumentList& args)
+    {
+        if (!args.containsOption("--output-dir"))
+            juce::ConsoleApplication::fail("Batch mode needs --output-dir");
+        
+        auto outputDir = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--output-dir"));
+        if (!outputDir.createDirectory())
+            juce::ConsoleApplication::fail("Can't create " + outputDir.getFullPathName());
+        
+        auto prompts = getBatchPrompts(args);
+        if (args.containsOption("--gemini"))
+            prompts = prepareWithGemini(prompts);
+        
+        const auto inputs = getBatchInputs(args);
+        const float intensity = args.containsOption("--intensity") ? args.getValueForOption("--intensity").getFloatValue() : 1.0f;
+        
+        // Outputs are written while other workers read the inputs, so no
+        // output may be an input, e.g. an earlier run's result left in the input folder
+        std::set<juce::uint64> inputIdentifiers;
+        for (const auto& input : inputs)
+            if (const auto identifier = input.getFileIdentifier(); identifier != 0)
+                inputIdentifiers.insert(identifier);
+        
+        std::vector<RenderJob> jobs;
+        juce::StringArray outputNames;
+        for (const auto& input : inputs)
+        {
+            for (int i = 0; i < prompts.size(); ++i)
+            {
+                RenderJob job;
+                job.input = input;
+                job.prompt = prompts[i];
+                job.intensity = intensity;
+                
+                auto name = input.getFileNameWithoutExtension();
+                if (prompts.size() > 1)
+                    name << "_" << juce::String(i + 1).paddedLeft('0', 3);
+                
+                // Inputs from different folders can share a name; every job
+                // needs a file of its own, or two workers would write one
+                auto outputName = name + input.getFileExtension();
+                for (int copy = 2; outputNames.contains(outputName, true); ++copy)
+                    outputName = name + "_" + juce::String(copy) + input.getFileExtension();
+                
+                outputNames.add(outputName);
+                job.output = outputDir.getChildFile(outputName);
+                
+                if (job.output.existsAsFile() && inputIdentifiers.count(job.output.getFileIdentifier()) > 0)
+                    juce::ConsoleApplication::fail(job.output.getFullPathName() + " is one of the inputs; use an --output-dir that holds no inputs");
+                
+                jobs.push_back(job);
+            }
+        }
+        
+        BatchRenderer renderer(getRenderSettings(args), args.getValueForOption("--threads").getIntValue());
+        std::cout << "Rendering " << jobs.size() << " jobs on " << renderer.getNumThreads() << " threads" << std::endl;
+        
+        const double startMs = juce::Time::getMillisecondCounterHiRes();
+        auto results = renderer.render(jobs, [](const BatchResult& result)
+        {
+            if (result.success)
+                std::cout << result.job.output.getFileName() << ": " << juce::String(result.audioSeconds / juce::jmax(result.renderSeconds, 1.0e-6), 1)
+                          << "x real time" << std::endl;
+            else
+                std::cerr << result.job.input.getFileName() << ": " << result.error << std::endl;
+        });
+        const double elapsedSeconds = (juce::Time::getMillisecondCounterHiRes() - startMs) * 0.001;
+        
+        int failures = 0;
+        double audioSeconds = 0.0;
+        for (const auto& result : results)
+        {
+            audioSeconds += result.audioSeconds;
+            if (!result.success)
+                ++failures;
+        }
+        
+        std::cout << juce::String(audioSeconds, 1) << " s of audio in " << juce::String(elapsedSeconds, 2) << " s ("
+                  << juce::String(audioSeconds / juce::jmax(elapsedSeconds, 1.0e-6), 1) << "x real time)" << std::endl;
+        
+        if (failures > 0)
+            juce::ConsoleApplication::fail(juce::String(failures) + " of " + juce::String((int)results.size()) + " jobs failed");
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", usage, false);
+    app.addCommand({ "--batch", "--batch --output-dir=<dir> [options] [files...]", "Render many files and/or prompts on all cores", "",
+                     [](const juce::ArgumentList& args) { renderBatch(args); } });
+    app.addDefaultCommand({ "", "[options] <input> <output>", "Render a file through the Sonara chain", "",
+                            [](const juce::ArgumentList& args) { renderFile(args); } });
+    
+    return app.findAndRunCommand(argc, argv);
+}
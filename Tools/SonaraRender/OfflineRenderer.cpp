@@ -0,0 +1,123 @@
+#include "OfflineRenderer.h"
+#include <cmath>
+
+OfflineRenderer::OfflineRenderer(const RenderSettings& s) : settings(s)
+{
+    formatManager.registerBasicFormats();
+}
+
+bool OfflineRenderer::render(const RenderJob& job)
+{
+    lastError.clear();
+    lastRenderedSamples = 0;
+    lastRenderedSeconds = 0.0;
+    
+    // Writing starts by deleting the output, which would destroy the input
+    if (isSameFile(job.input, job.output))
+    {
+        lastError = "Output would overwrite the input: " + job.output.getFullPathName();
+        return false;
+    }
+    
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(job.input));
+    if (reader == nullptr)
+    {
+        lastError = "Can't read " + job.input.getFullPathName();
+        return false;
+    }
+    
+    const int numChannels = (int)reader->numChannels;
+    if (numChannels < 1 || numChannels > 2)
+    {
+        lastError = job.input.getFileName() + " has " + juce::String(numChannels) + " channels, only mono and stereo are supported";
+        return false;
+    }
+    
+    auto writer = createWriter(job.output, *reader);
+    if (writer == nullptr)
+        return false;
+    
+    // Map the prompt once and start the chain on those settings, no glide
+    processingChain.prepare({ reader->sampleRate, (juce::uint32)settings.blockSize, (juce::uint32)numChannels });
+    processingChain.setParameters(keywordMapper.processText(job.prompt, job.intensity));
+    processingChain.reset();
+    
+    buffer.setSize(numChannels, settings.blockSize, false, false, true);
+    
+    const juce::int64 inputLength = reader->lengthInSamples;
+    const double tailSeconds = settings.automaticTail ? processingChain.getTailLengthSeconds() : settings.tailSeconds;
+    juce::int64 totalLength = inputLength + (juce::int64)std::ceil(tailSeconds * reader->sampleRate);
+    
+    for (juce::int64 position = 0; position < totalLength; position += settings.blockSize)
+    {
+        if (settings.automaticTail && position >= inputLength && processingChain.isSleeping())
+        {
+            totalLength = position;
+            break;
+        }
+        
+        const int numSamples = (int)juce::jmin((juce::int64)settings.blockSize, totalLength - position);
+        buffer.setSize(numChannels, numSamples, false, false, true);
+        
+        // Reading past the end of the input fills the tail with silence
+        if (!reader->read(&buffer, 0, numSamples, position, true, true))
+        {
+            lastError = "Read error in " + job.input.getFileName();
+            return false;
+        }
+        
+        processingChain.processBlock(buffer);
+        
+        if (!writer->writeFromAudioSampleBuffer(buffer, 0, numSamples))
+        {
+            lastError = "Write error in " + job.output.getFileName();
+            return false;
+        }
+    }
+    
+    lastRenderedSamples = totalLength;
+    lastRenderedSeconds = (double)totalLength / reader->sampleRate;
+    return true;
+}
+
+bool OfflineRenderer::isSameFile(const juce::File& a, const juce::File& b)
+{
+    if (a.getLinkedTarget() == b.getLinkedTarget())
+        return true;
+    
+    // Hard links, or one path spelt differently
+    return a.existsAsFile() && b.existsAsFile() && a.getFileIdentifier() == b.getFileIdentifier();
+}
+
+std::unique_ptr<juce::AudioFormatWriter> OfflineRenderer::createWriter(const juce::File& file, const juce::AudioFormatReader& reader)
+{
+    auto* format = formatManager.findFormatForFileExtension(file.getFileExtension());
+    if (format == nullptr)
+    {
+        lastError = "Unsupported output format: " + file.getFileName();
+        return nullptr;
+    }
+    
+    file.deleteFile();
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if (!stream->openedOk())
+    {
+        lastError = "Can't write " + file.getFullPathName();
+        return nullptr;
+    }
+    
+    // Keep the source bit depth where the output format allows it
+    const int bitsPerSample = format->getPossibleBitDepths().contains((int)reader.bitsPerSample) ? (int)reader.bitsPerSample : 24;
+    
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), reader.sampleRate, reader.numChannels,
+                                                                            bitsPerSample, juce::StringPairArray(), 0));
+    if (writer == nullptr)
+    {
+        lastError = "Can't create a " + format->getFormatName() + " writer for " + file.getFileName();
+        return nullptr;
+    }
+    
+    // The writer owns the stream now
+    stream.release();
+    return writer;
+}
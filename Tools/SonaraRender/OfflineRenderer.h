@@ -0,0 +1,71 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include "../../Source/AudioProcessing/ProcessingChain.h"
+#include "../../Source/KeywordMapper.h"
+
+/**
+ * One file to render: the prompt is mapped with KeywordMapper and the
+ * result is applied to the whole file.
+ */
+struct RenderJob
+{
+    juce::File input;
+    juce::File output;
+    juce::String prompt;
+    float intensity = 1.0f;
+};
+
+struct RenderSettings
+{
+    // Samples per processing block; large blocks keep per-block overhead low
+    int blockSize = 4096;
+    
+    // Extra silence rendered after the input so reverb tails aren't cut off
+    double tailSeconds = 0.0;
+    
+    // Instead of tailSeconds, render until the tail has actually decayed
+    // (at most the chain's computed tail length)
+    bool automaticTail = false;
+};
+
+/**
+ * Streams a WAV/AIFF file through the same ProcessingChain the plugin uses.
+ * Memory use is one block of audio regardless of the file's length.
+ */
+class OfflineRenderer
+{
+public:
+    explicit OfflineRenderer(const RenderSettings& settings);
+    
+    /**
+     * Render a single job.
+     * @return true if the output file was written, otherwise see getLastError()
+     */
+    bool render(const RenderJob& job);
+    
+    juce::String getLastError() const { return lastError; }
+    
+    /**
+     * True if both refer to one file: the same path once symlinks are
+     * followed, or (for existing files) the same file on disk.
+     */
+    static bool isSameFile(const juce::File& a, const juce::File& b);
+    
+    /** Length of the last rendered output, in samples and in seconds. */
+    juce::int64 getLastRenderedSamples() const { return lastRenderedSamples; }
+    double getLastRenderedSeconds() const { return lastRenderedSeconds; }
+    
+private:
+    RenderSettings settings;
+    juce::AudioFormatManager formatManager;
+    KeywordMapper keywordMapper;
+    ProcessingChain<float> processingChain;
+    juce::AudioBuffer<float> buffer;
+    
+    juce::String lastError;
+    juce::int64 lastRenderedSamples = 0;
+    double lastRenderedSeconds = 0.0;
+    
+    std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file, const juce::AudioFormatReader& reader);
+};
@@ -0,0 +1,64 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(int numWorkers) : queues((size_t)std::max(1, numWorkers))
+{
+}
+
+void WorkStealingPool::run(const std::vector<Task>& tasks)
+{
+    const size_t numWorkers = queues.size();
+    
+    for (size_t i = 0; i < tasks.size(); ++i)
+        queues[i % numWorkers].taskIndices.push_back(i);
+    
+    std::vector<std::thread> workers;
+    workers.reserve(numWorkers);
+    
+    for (size_t worker = 0; worker < numWorkers; ++worker)
+    {
+        workers.emplace_back([this, &tasks, worker]
+        {
+            size_t taskIndex = 0;
+            while (takeTask((int)worker, taskIndex))
+                tasks[taskIndex]((int)worker);
+        });
+    }
+    
+    for (auto& worker : workers)
+        worker.join();
+}
+
+bool WorkStealingPool::takeTask(int workerIndex, size_t& taskIndex)
+{
+    const size_t numWorkers = queues.size();
+    
+    // Own queue first, oldest (largest) task first
+    {
+        auto& own = queues[(size_t)workerIndex];
+        std::lock_guard<std::mutex> lock(own.lock);
+        if (!own.taskIndices.empty())
+        {
+            taskIndex = own.taskIndices.front();
+            own.taskIndices.pop_front();
+            return true;
+        }
+    }
+    
+    // Then steal the newest (smallest) task from whoever still has work.
+    // Nothing is added while running, so all queues empty means done.
+    for (size_t offset = 1; offset < numWorkers; ++offset)
+    {
+        auto& victim = queues[((size_t)workerIndex + offset) % numWorkers];
+        std::lock_guard<std::mutex> lock(victim.lock);
+        if (!victim.taskIndices.empty())
+        {
+            taskIndex = victim.taskIndices.back();
+            victim.taskIndices.pop_back();
+            return true;
+        }
+    }
+    
+    return false;
+}
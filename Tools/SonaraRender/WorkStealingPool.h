@@ -0,0 +1,40 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * Runs a fixed set of coarse tasks (whole files) on a group of threads.
+ *
+ * Tasks are dealt out round-robin up front. Each worker takes from the front
+ * of its own queue; once that is empty it steals from the back of the other
+ * queues. Hand tasks over largest first and workers start on their biggest
+ * jobs while the small ones at the tail are what get stolen, which keeps
+ * every core busy until the end.
+ */
+class WorkStealingPool
+{
+public:
+    /** A task gets the index of the worker running it, in [0, numWorkers). */
+    using Task = std::function<void(int workerIndex)>;
+    
+    explicit WorkStealingPool(int numWorkers);
+    
+    int getNumWorkers() const { return (int)queues.size(); }
+    
+    /** Runs every task and returns once they have all finished. */
+    void run(const std::vector<Task>& tasks);
+    
+private:
+    struct WorkerQueue
+    {
+        std::mutex lock;
+        std::deque<size_t> taskIndices;
+    };
+    
+    std::vector<WorkerQueue> queues;
+    
+    bool takeTask(int workerIndex, size_t& taskIndex);
+};